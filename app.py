@@ -37,11 +37,11 @@ class Contact:
 def index():
     return render_template("index.html")
 
-@app.route('/edges/', defaults={'feature': ''})
-
-@app.route('/edges/<feature>')
-def get_edges(feature):
-    result = subprocess.run(['./generate_edges', feature], capture_output=True, text=True)
+def run_generator(feature):
+    # query string goes through as --key=value, e.g. /edges/composite?threshold=3 or /edges/similar/Ana?k=5
+    # (?kcore=k works on every view and keeps only its k-core)
+    args = ['./generate_edges', feature] + [f"--{key}={value}" for key, value in request.args.items()]
+    result = subprocess.run(args, capture_output=True, text=True)
     print("[CPP STDOUT]", result.stdout.strip())
     print("[CPP STDERR]", result.stderr.strip())
 
@@ -60,6 +60,26 @@ def get_edges(feature):
         return jsonify({"error": "Invalid JSON from C++"}), 500
 
 
+@app.route('/edges/', defaults={'feature': ''})
+
+@app.route('/edges/<path:feature>')
+def get_edges(feature):
+    return run_generator(feature)
+
+
+@app.route('/path/<path:name>')
+def get_path(name):
+    # "how do I reach name?": /path/Ana?k=3&mode=hops&from=Bob, same as ./generate_edges path/Ana --k=3 ...
+    return run_generator(f"path/{name}")
+
+
+@app.route('/meet/', defaults={'name': ''})
+@app.route('/meet/<path:name>')
+def get_meet(name):
+    # "who should I (or name) get to know?": /meet?k=5 or /meet/Ana?strong=8, same as ./generate_edges meet/Ana ...
+    return run_generator(f"meet/{name}" if name else "meet")
+
+
 def load_all_contacts(db_path="my_database.db"):
     conn = sqlite3.connect(db_path)
     cur = conn.cursor()
@@ -176,6 +196,31 @@ def data():
 
     return jsonify({"nodes": nodes})
 
+def refresh_groups():
+    # keeps the *_groups tables in step with my_database.db; only groups whose members changed are rewritten.
+    # It also resolves the company and school names just saved into contact_organizations, which
+    # every generate_edges graph view reads instead of the raw columns.
+    result = subprocess.run(['./build_groups', '--incremental'], capture_output=True, text=True)
+    if result.returncode != 0:
+        print("[GROUPS ERROR]", result.stderr.strip())
+
+
+def refresh_graph_cache():
+    # recomputes the composite graph's PageRank/eigenvector scores in graph_cache.db, so the
+    # /edges views only read them instead of rebuilding the graph per request
+    result = subprocess.run(['./generate_edges', '--refresh'], capture_output=True, text=True)
+    if result.returncode != 0:
+        print("[GRAPH CACHE ERROR]", result.stderr.strip())
+
+
+def refresh_contact_pairs(contact_id):
+    # recomputes only this contact's rows in the shared skills/interests/goals tables and its
+    # entry in contacts.hnsw, instead of rebuilding them for everyone
+    result = subprocess.run(['./shared_text_engine', f'--update={contact_id}'], capture_output=True, text=True)
+    if result.returncode != 0:
+        print("[PAIRS ERROR]", result.stderr.strip())
+
+
 @app.route("/add_contact", methods=["POST"])
 def add_contact():
     data = request.get_json()
@@ -256,6 +301,9 @@ def add_contact():
 
             conn.commit()
             conn.close()
+            refresh_groups()
+            refresh_contact_pairs(contact_id)
+            refresh_graph_cache()
             return jsonify({"success": True, "message": "Contact updated."})
 
         else:
@@ -289,6 +337,9 @@ def add_contact():
 
             conn.commit()
             conn.close()
+            refresh_groups()
+            refresh_contact_pairs(contact_id)
+            refresh_graph_cache()
             return jsonify({"success": True, "message": "Contact added."})
     except Exception as e:
         print("[ERROR]", e)
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+#include "bitset_kernels.h"
+
+// Microbenchmark for bitset_kernels.h: times the dispatched kernels against the scalar loops
+// on the same inputs and stops with an error if any of them disagree.
+//
+//   ./bitset_bench [--bits=65536] [--sets=4] [--ids=2000]
+
+
+struct Timing {
+    double scalarNs;
+    double fastNs;
+};
+
+
+template <typename F>
+double time_ns(F&& body, int repeats) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) body();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+
+// volatile sink so the timed loops aren't optimized away
+volatile uint64_t sink;
+
+void report(const std::string& name, const Timing& t, double bytes) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << t.scalarNs << " ns" << std::setw(12) << t.fastNs << " ns"
+              << std::setw(9) << t.scalarNs / t.fastNs << "x"
+              << std::setw(10) << bytes / t.fastNs << " GB/s" << std::endl;
+}
+
+
+bool check(const std::string& name, uint64_t scalar, uint64_t fast) {
+    if (scalar == fast) return true;
+    std::cerr << name << ": scalar " << scalar << " != dispatched " << fast << std::endl;
+    return false;
+}
+
+
+std::vector<uint32_t> random_ids(std::mt19937_64& rng, size_t count, uint32_t universe) {
+    std::vector<uint32_t> ids;
+    std::uniform_int_distribution<uint32_t> pick(0, universe - 1);
+    while (ids.size() < count) {
+        ids.push_back(pick(rng));
+        if (ids.size() == count) {
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+    }
+    return ids;
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t bits = 65536, sets = 4, ids = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        size_t value = eq == std::string::npos ? 0 : std::strtoul(arg.c_str() + eq + 1, nullptr, 10);
+        if (arg.rfind("--bits=", 0) == 0) bits = value;
+        else if (arg.rfind("--sets=", 0) == 0) sets = value;
+        else if (arg.rfind("--ids=", 0) == 0) ids = value;
+        else {
+            std::cerr << "Usage: ./bitset_bench [--bits=N] [--sets=K] [--ids=N]" << std::endl;
+            return 1;
+        }
+    }
+    if (bits < 64 || sets < 2 || ids < 1) {
+        std::cerr << "Need --bits >= 64, --sets >= 2, --ids >= 1" << std::endl;
+        return 1;
+    }
+
+    const BitsetKernels& scalar = scalar_bitset_kernels();
+    const BitsetKernels& fast = bitset_kernels();
+    std::cout << "dispatched kernels: " << fast.name << std::endl;
+    std::cout << std::left << std::setw(28) << "" << std::right << std::setw(15) << "scalar" << std::setw(15)
+              << fast.name << std::setw(10) << "speedup" << std::endl;
+
+    std::mt19937_64 rng(7);
+    size_t words = (bits + 63) / 64;
+    std::vector<std::vector<uint64_t>> dense(sets, std::vector<uint64_t>(words));
+    for (auto& set : dense) {
+        // about one bit in three set, so ANDs of a few sets stay non-empty
+        for (auto& w : set) w = (rng() & rng()) | (rng() & rng() & rng());
+    }
+    std::vector<const uint64_t*> inputs;
+    for (const auto& set : dense) inputs.push_back(set.data());
+    std::vector<uint64_t> out(words);
+
+    int repeats = static_cast<int>(std::max<size_t>(10, 200000000 / (bits + 1)));
+    double bytes = static_cast<double>(words * 8);
+    bool ok = true;
+
+    ok = check("popcount", scalar.popcount(inputs[0], words), fast.popcount(inputs[0], words)) && ok;
+    report("popcount", {time_ns([&] { sink = scalar.popcount(inputs[0], words); }, repeats),
+                        time_ns([&] { sink = fast.popcount(inputs[0], words); }, repeats)}, bytes);
+
+    ok = check("and_popcount", scalar.and_popcount(inputs[0], inputs[1], words),
+               fast.and_popcount(inputs[0], inputs[1], words)) && ok;
+    report("and_popcount", {time_ns([&] { sink = scalar.and_popcount(inputs[0], inputs[1], words); }, repeats),
+                            time_ns([&] { sink = fast.and_popcount(inputs[0], inputs[1], words); }, repeats)}, 2 * bytes);
+
+    ok = check("and_into", scalar.and_into(out.data(), inputs[0], inputs[1], words),
+               fast.and_into(out.data(), inputs[0], inputs[1], words)) && ok;
+    report("and_into", {time_ns([&] { sink = scalar.and_into(out.data(), inputs[0], inputs[1], words); }, repeats),
+                        time_ns([&] { sink = fast.and_into(out.data(), inputs[0], inputs[1], words); }, repeats)}, 3 * bytes);
+
+    std::string many = "and_many (" + std::to_string(sets) + " sets)";
+    ok = check(many, scalar.and_many(nullptr, inputs.data(), sets, words), fast.and_many(nullptr, inputs.data(), sets, words)) && ok;
+    report(many, {time_ns([&] { sink = scalar.and_many(nullptr, inputs.data(), sets, words); }, repeats),
+                  time_ns([&] { sink = fast.and_many(nullptr, inputs.data(), sets, words); }, repeats)}, sets * bytes);
+
+    // compressed: similar sizes (block compare) and one side much longer (galloping)
+    uint32_t universe = static_cast<uint32_t>(ids * 4);
+    std::vector<uint32_t> a = random_ids(rng, ids, universe);
+    std::vector<uint32_t> b = random_ids(rng, ids, universe);
+    std::vector<uint32_t> small = random_ids(rng, std::max<size_t>(1, ids / 64), universe);
+    int idRepeats = static_cast<int>(std::max<size_t>(10, 50000000 / ids));
+
+    ok = check("intersect_count", scalar.intersect_count(a.data(), a.size(), b.data(), b.size()),
+               fast.intersect_count(a.data(), a.size(), b.data(), b.size())) && ok;
+    report("intersect_count (equal)", {time_ns([&] { sink = scalar.intersect_count(a.data(), a.size(), b.data(), b.size()); }, idRepeats),
+                                       time_ns([&] { sink = fast.intersect_count(a.data(), a.size(), b.data(), b.size()); }, idRepeats)},
+           4.0 * (a.size() + b.size()));
+
+    ok = check("intersect_count (skewed)", scalar.intersect_count(small.data(), small.size(), b.data(), b.size()),
+               fast.intersect_count(small.data(), small.size(), b.data(), b.size())) && ok;
+    report("intersect_count (skewed)", {time_ns([&] { sink = scalar.intersect_count(small.data(), small.size(), b.data(), b.size()); }, idRepeats),
+                                        time_ns([&] { sink = fast.intersect_count(small.data(), small.size(), b.data(), b.size()); }, idRepeats)},
+           4.0 * (small.size() + b.size()));
+
+    // a plain merge as the reference for the compressed kernels
+    std::vector<uint32_t> merged;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged));
+    ok = check("intersect_sorted", merged.size(), intersect_sorted(a, b).size()) && ok;
+    ok = check("intersect_count vs merge", merged.size(), fast.intersect_count(a.data(), a.size(), b.data(), b.size())) && ok;
+
+    if (!ok) return 1;
+    std::cout << "all kernels agree" << std::endl;
+    return 0;
+}
+
+
+/* to compile use this command
+
+g++ bitset_bench.cpp -o bitset_bench -O2 -I.
+
+*/
@@ -0,0 +1,429 @@
+#ifndef BITSET_KERNELS_H
+#define BITSET_KERNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITSET_KERNELS_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BITSET_KERNELS_NEON 1
+#endif
+
+// Set-overlap kernels for "how many groups / terms / neighbours do these two share".
+//
+// Two representations:
+//   dense       uint64_t words, bit i set when member i is in the set. Best when sets are a
+//               sizeable fraction of the universe (group membership over a few thousand people).
+//   compressed  sorted, duplicate-free uint32_t ids. Best for sparse sets (term sets, adjacency).
+//
+// bitset_kernels() picks AVX2, POPCNT, NEON or plain loops once per process; every variant
+// returns the same answers, bitset_bench.cpp checks that and times them.
+
+
+// ---- scalar ------------------------------------------------------------------------------
+
+inline uint64_t popcount64(uint64_t x) {
+    // portable SWAR count for CPUs without a popcount instruction
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (x * 0x0101010101010101ull) >> 56;
+}
+
+inline uint64_t popcount_scalar(const uint64_t *a, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) total += popcount64(a[i]);
+    return total;
+}
+
+inline uint64_t and_popcount_scalar(const uint64_t *a, const uint64_t *b, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) total += popcount64(a[i] & b[i]);
+    return total;
+}
+
+// dst = a & b, returns the popcount of dst
+inline uint64_t and_into_scalar(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) {
+        dst[i] = a[i] & b[i];
+        total += popcount64(dst[i]);
+    }
+    return total;
+}
+
+// dst = inputs[0] & ... & inputs[count - 1] in one pass, returns its popcount
+inline uint64_t and_many_scalar(uint64_t *dst, const uint64_t *const *inputs, size_t count, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t w = count ? inputs[0][i] : 0;
+        for (size_t k = 1; k < count; ++k) w &= inputs[k][i];
+        if (dst) dst[i] = w;
+        total += popcount64(w);
+    }
+    return total;
+}
+
+// first index in [from, n) with a[index] >= value, probing 1, 2, 4, ... ahead first
+inline size_t gallop(const uint32_t *a, size_t from, size_t n, uint32_t value) {
+    size_t step = 1, low = from, high = from;
+    while (high < n && a[high] < value) {
+        low = high + 1;
+        high = from + step;
+        step <<= 1;
+    }
+    return static_cast<size_t>(std::lower_bound(a + low, a + std::min(high, n), value) - a);
+}
+
+// when one side is this many times longer, skipping through it beats walking it
+const size_t GALLOP_RATIO = 32;
+
+inline size_t intersect_count_scalar(const uint32_t *a, size_t na, const uint32_t *b, size_t nb) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    size_t count = 0;
+    if (na * GALLOP_RATIO < nb) {
+        size_t j = 0;
+        for (size_t i = 0; i < na && j < nb; ++i) {
+            j = gallop(b, j, nb, a[i]);
+            if (j < nb && b[j] == a[i]) ++count;
+        }
+        return count;
+    }
+    size_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        uint32_t x = a[i], y = b[j];
+        count += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return count;
+}
+
+// writes the shared ids to out (room for min(na, nb)), returns how many
+inline size_t intersect_sorted(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    size_t count = 0;
+    if (na * GALLOP_RATIO < nb) {
+        size_t j = 0;
+        for (size_t i = 0; i < na && j < nb; ++i) {
+            j = gallop(b, j, nb, a[i]);
+            if (j < nb && b[j] == a[i]) out[count++] = a[i];
+        }
+        return count;
+    }
+    size_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            out[count++] = a[i];
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+inline std::vector<uint32_t> intersect_sorted(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) {
+    std::vector<uint32_t> out(std::min(a.size(), b.size()));
+    out.resize(intersect_sorted(a.data(), a.size(), b.data(), b.size(), out.data()));
+    return out;
+}
+
+
+// ---- x86: POPCNT and AVX2 ----------------------------------------------------------------
+
+#ifdef BITSET_KERNELS_X86
+__attribute__((target("popcnt")))
+inline uint64_t popcount_popcnt(const uint64_t *a, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) total += _mm_popcnt_u64(a[i]);
+    return total;
+}
+
+__attribute__((target("popcnt")))
+inline uint64_t and_popcount_popcnt(const uint64_t *a, const uint64_t *b, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) total += _mm_popcnt_u64(a[i] & b[i]);
+    return total;
+}
+
+__attribute__((target("popcnt")))
+inline uint64_t and_into_popcnt(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) {
+        dst[i] = a[i] & b[i];
+        total += _mm_popcnt_u64(dst[i]);
+    }
+    return total;
+}
+
+__attribute__((target("popcnt")))
+inline uint64_t and_many_popcnt(uint64_t *dst, const uint64_t *const *inputs, size_t count, size_t words) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t w = count ? inputs[0][i] : 0;
+        for (size_t k = 1; k < count; ++k) w &= inputs[k][i];
+        if (dst) dst[i] = w;
+        total += _mm_popcnt_u64(w);
+    }
+    return total;
+}
+
+// per-byte popcount by nibble lookup (Mula), summed into four 64-bit lanes with SAD
+__attribute__((target("avx2")))
+inline __m256i popcount_bytes_avx2(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+                                     _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+inline uint64_t sum_lanes_avx2(__m256i v) {
+    return static_cast<uint64_t>(_mm256_extract_epi64(v, 0)) + static_cast<uint64_t>(_mm256_extract_epi64(v, 1)) +
+           static_cast<uint64_t>(_mm256_extract_epi64(v, 2)) + static_cast<uint64_t>(_mm256_extract_epi64(v, 3));
+}
+
+__attribute__((target("avx2,popcnt")))
+inline uint64_t popcount_avx2(const uint64_t *a, size_t words) {
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        sum = _mm256_add_epi64(sum, popcount_bytes_avx2(v));
+    }
+    uint64_t total = sum_lanes_avx2(sum);
+    for (; i < words; ++i) total += _mm_popcnt_u64(a[i]);
+    return total;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline uint64_t and_popcount_avx2(const uint64_t *a, const uint64_t *b, size_t words) {
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+        sum = _mm256_add_epi64(sum, popcount_bytes_avx2(v));
+    }
+    uint64_t total = sum_lanes_avx2(sum);
+    for (; i < words; ++i) total += _mm_popcnt_u64(a[i] & b[i]);
+    return total;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline uint64_t and_into_avx2(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t words) {
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+        sum = _mm256_add_epi64(sum, popcount_bytes_avx2(v));
+    }
+    uint64_t total = sum_lanes_avx2(sum);
+    for (; i < words; ++i) {
+        dst[i] = a[i] & b[i];
+        total += _mm_popcnt_u64(dst[i]);
+    }
+    return total;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline uint64_t and_many_avx2(uint64_t *dst, const uint64_t *const *inputs, size_t count, size_t words) {
+    if (count == 0) return and_many_scalar(dst, inputs, count, words);
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inputs[0] + i));
+        for (size_t k = 1; k < count; ++k) {
+            v = _mm256_and_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inputs[k] + i)));
+        }
+        if (dst) _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+        sum = _mm256_add_epi64(sum, popcount_bytes_avx2(v));
+    }
+    uint64_t total = sum_lanes_avx2(sum);
+    for (; i < words; ++i) {
+        uint64_t w = inputs[0][i];
+        for (size_t k = 1; k < count; ++k) w &= inputs[k][i];
+        if (dst) dst[i] = w;
+        total += _mm_popcnt_u64(w);
+    }
+    return total;
+}
+
+// Compares blocks of 8 ids from each side all-against-all (8 rotations of one block), then
+// drops whichever block ends lower. Ids are unique per side, so each match is seen once.
+__attribute__((target("avx2,popcnt")))
+inline size_t intersect_count_avx2(const uint32_t *a, size_t na, const uint32_t *b, size_t nb) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (na * GALLOP_RATIO < nb || na < 8) return intersect_count_scalar(a, na, b, nb);
+
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    size_t count = 0, i = 0, j = 0;
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + j));
+        __m256i hits = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; ++r) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi32(va, vb));
+        }
+        count += _mm_popcnt_u32(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(hits))));
+
+        uint32_t lastA = a[i + 7], lastB = b[j + 7];
+        i += lastA <= lastB ? 8 : 0;
+        j += lastB <= lastA ? 8 : 0;
+    }
+    // plain merge for the rest; a kept block's ids that already matched were matched against a
+    // dropped block, so they are below everything left on the other side and can't match again
+    while (i < na && j < nb) {
+        uint32_t x = a[i], y = b[j];
+        count += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return count;
+}
+#endif
+
+
+// ---- ARM: NEON ---------------------------------------------------------------------------
+
+#ifdef BITSET_KERNELS_NEON
+inline uint64_t popcount_neon(const uint64_t *a, size_t words) {
+    uint64x2_t sum = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= words; i += 2) {
+        uint8x16_t bytes = vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(a + i)));
+        sum = vpadalq_u32(sum, vpaddlq_u16(vpaddlq_u8(bytes)));
+    }
+    uint64_t total = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+    for (; i < words; ++i) total += popcount64(a[i]);
+    return total;
+}
+
+inline uint64_t and_popcount_neon(const uint64_t *a, const uint64_t *b, size_t words) {
+    uint64x2_t sum = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= words; i += 2) {
+        uint64x2_t v = vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i));
+        sum = vpadalq_u32(sum, vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(v)))));
+    }
+    uint64_t total = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+    for (; i < words; ++i) total += popcount64(a[i] & b[i]);
+    return total;
+}
+
+inline uint64_t and_into_neon(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t words) {
+    uint64x2_t sum = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= words; i += 2) {
+        uint64x2_t v = vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i));
+        vst1q_u64(dst + i, v);
+        sum = vpadalq_u32(sum, vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(v)))));
+    }
+    uint64_t total = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+    for (; i < words; ++i) {
+        dst[i] = a[i] & b[i];
+        total += popcount64(dst[i]);
+    }
+    return total;
+}
+
+inline uint64_t and_many_neon(uint64_t *dst, const uint64_t *const *inputs, size_t count, size_t words) {
+    if (count == 0) return and_many_scalar(dst, inputs, count, words);
+    uint64x2_t sum = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= words; i += 2) {
+        uint64x2_t v = vld1q_u64(inputs[0] + i);
+        for (size_t k = 1; k < count; ++k) v = vandq_u64(v, vld1q_u64(inputs[k] + i));
+        if (dst) vst1q_u64(dst + i, v);
+        sum = vpadalq_u32(sum, vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(v)))));
+    }
+    uint64_t total = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+    for (; i < words; ++i) {
+        uint64_t w = inputs[0][i];
+        for (size_t k = 1; k < count; ++k) w &= inputs[k][i];
+        if (dst) dst[i] = w;
+        total += popcount64(w);
+    }
+    return total;
+}
+#endif
+
+
+// ---- dispatch ----------------------------------------------------------------------------
+
+struct BitsetKernels {
+    const char *name;
+    uint64_t (*popcount)(const uint64_t *a, size_t words);
+    uint64_t (*and_popcount)(const uint64_t *a, const uint64_t *b, size_t words);
+    uint64_t (*and_into)(uint64_t *dst, const uint64_t *a, const uint64_t *b, size_t words);
+    uint64_t (*and_many)(uint64_t *dst, const uint64_t *const *inputs, size_t count, size_t words);  // dst may be null
+    size_t (*intersect_count)(const uint32_t *a, size_t na, const uint32_t *b, size_t nb);
+};
+
+inline const BitsetKernels &scalar_bitset_kernels() {
+    static const BitsetKernels kernels = {"scalar", popcount_scalar, and_popcount_scalar, and_into_scalar,
+                                          and_many_scalar, intersect_count_scalar};
+    return kernels;
+}
+
+inline const BitsetKernels &bitset_kernels() {
+    static const BitsetKernels kernels = [] {
+#ifdef BITSET_KERNELS_X86
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+            return BitsetKernels{"avx2", popcount_avx2, and_popcount_avx2, and_into_avx2, and_many_avx2,
+                                 intersect_count_avx2};
+        }
+        if (__builtin_cpu_supports("popcnt")) {
+            return BitsetKernels{"popcnt", popcount_popcnt, and_popcount_popcnt, and_into_popcnt, and_many_popcnt,
+                                 intersect_count_scalar};
+        }
+#endif
+#ifdef BITSET_KERNELS_NEON
+        return BitsetKernels{"neon", popcount_neon, and_popcount_neon, and_into_neon, and_many_neon,
+                             intersect_count_scalar};
+#endif
+        return scalar_bitset_kernels();
+    }();
+    return kernels;
+}
+
+
+// a fixed-size dense set over [0, size)
+struct DenseBitset {
+    std::vector<uint64_t> words;
+
+    explicit DenseBitset(size_t size = 0) : words((size + 63) / 64, 0) {}
+
+    void set(size_t i) { words[i >> 6] |= 1ull << (i & 63); }
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    uint64_t count() const { return bitset_kernels().popcount(words.data(), words.size()); }
+
+    uint64_t and_count(const DenseBitset &other) const {
+        return bitset_kernels().and_popcount(words.data(), other.words.data(), std::min(words.size(), other.words.size()));
+    }
+};
+
+#endif
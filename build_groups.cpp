@@ -0,0 +1,373 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include "sqlite3.h"
+#include "pair_map.h"
+#include "text_normalize.h"
+#include "entity_resolution.h"
+
+// Rebuilds the five *_groups tables from my_database.db in one pass, and relinks every contact
+// to its organizations in contact_organizations (app.py runs this after each /add_contact).
+//
+//   ./build_groups                  wipe and rewrite every group
+//   ./build_groups --incremental    only touch groups whose member list changed
+
+struct GroupTable {
+    const char* dbFile;
+    const char* schema;  // name the db is attached under
+    const char* table;
+    const char* column;
+    int field;           // column of the scan query holding the values
+    const char* entity;  // EntityResolver kind the values are resolved with, or nullptr
+    const char* source;  // contact column the values come from, as named in contact_organizations
+};
+
+const GroupTable GROUP_TABLES[] = {
+    {"company_groups.db",     "company_groups",     "company_groups",     "company",    1, "company", "current_company"},
+    {"previous_companies.db", "previous_companies", "previous_companies", "company",    2, "company", "previous_companies"},
+    {"industry_groups.db",    "industry_groups",    "industry_groups",    "industry",   3, nullptr,   "industry"},
+    {"college_groups.db",     "college_groups",     "college_groups",     "college",    4, "school",  "college"},
+    {"highschool_groups.db",  "highschool_groups",  "highschool_groups",  "highschool", 5, "school",  "high_school"},
+};
+
+const int GROUP_TABLE_COUNT = sizeof(GROUP_TABLES) / sizeof(GROUP_TABLES[0]);
+
+
+std::string getSafeText(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+
+bool exec(sqlite3* db, const std::string& sql) {
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), NULL, 0, &errorMessage) != SQLITE_OK) {
+        std::cerr << "SQL error: " << errorMessage << "\n  in: " << sql << std::endl;
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    return true;
+}
+
+
+// one group kind: interned values, and for each value the people holding it in scan order
+struct Groups {
+    Interner values;
+    std::vector<std::vector<uint32_t>> members;
+
+    void add(const std::string& value, uint32_t person) {
+        uint32_t id = values.intern(value);
+        if (id == members.size()) members.emplace_back();
+
+        auto& people = members[id];
+        // people are scanned in order, so a repeated value only needs a back() check
+        if (people.empty() || people.back() != person) people.push_back(person);
+    }
+};
+
+
+std::string join_people(const std::vector<uint32_t>& people, const Interner& names) {
+    std::string joined;
+    for (uint32_t person : people) {
+        if (!joined.empty()) joined += ", ";
+        joined += names.names[person];
+    }
+    return joined;
+}
+
+
+struct WriteCounts {
+    int inserted = 0;
+    int updated = 0;
+    int deleted = 0;
+    int unchanged = 0;
+};
+
+
+bool rebuild_table(sqlite3* db, const GroupTable& t, const Groups& groups, const Interner& names, WriteCounts& counts) {
+    std::string prefix = std::string(t.schema) + "." + t.table;
+
+    sqlite3_stmt* countStmt;
+    std::string countSql = "SELECT COUNT(*) FROM " + prefix + ";";
+    if (sqlite3_prepare_v2(db, countSql.c_str(), -1, &countStmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (sqlite3_step(countStmt) == SQLITE_ROW) counts.deleted += sqlite3_column_int(countStmt, 0);
+    sqlite3_finalize(countStmt);
+
+    if (!exec(db, "DELETE FROM " + prefix + ";")) return false;
+
+    std::string insertSql = "INSERT OR IGNORE INTO " + prefix + " (" + t.column + ", people) VALUES (?, ?);";
+    sqlite3_stmt* insert;
+    if (sqlite3_prepare_v2(db, insertSql.c_str(), -1, &insert, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    for (size_t id = 0; id < groups.members.size(); ++id) {
+        std::string people = join_people(groups.members[id], names);
+        sqlite3_bind_text(insert, 1, groups.values.names[id].c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert, 2, people.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(insert) != SQLITE_DONE) {
+            std::cerr << "Insert failed: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_finalize(insert);
+            return false;
+        }
+        sqlite3_reset(insert);
+        ++counts.inserted;
+    }
+
+    sqlite3_finalize(insert);
+    return true;
+}
+
+
+bool update_table(sqlite3* db, const GroupTable& t, const Groups& groups, const Interner& names, WriteCounts& counts) {
+    std::string prefix = std::string(t.schema) + "." + t.table;
+
+    // what's stored now: value -> row ids and member lists (duplicates are possible with UNIQUE(value, people))
+    std::map<std::string, std::vector<std::pair<sqlite3_int64, std::string>>> stored;
+
+    sqlite3_stmt* select;
+    std::string selectSql = std::string("SELECT id, ") + t.column + ", people FROM " + prefix + ";";
+    if (sqlite3_prepare_v2(db, selectSql.c_str(), -1, &select, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    while (sqlite3_step(select) == SQLITE_ROW) {
+        stored[getSafeText(select, 1)].emplace_back(sqlite3_column_int64(select, 0), getSafeText(select, 2));
+    }
+    sqlite3_finalize(select);
+
+    std::string insertSql = "INSERT OR IGNORE INTO " + prefix + " (" + t.column + ", people) VALUES (?, ?);";
+    std::string updateSql = "UPDATE " + prefix + " SET people = ? WHERE id = ?;";
+    std::string deleteSql = "DELETE FROM " + prefix + " WHERE id = ?;";
+
+    sqlite3_stmt *insert = nullptr, *update = nullptr, *remove = nullptr;
+    if (sqlite3_prepare_v2(db, insertSql.c_str(), -1, &insert, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, updateSql.c_str(), -1, &update, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, deleteSql.c_str(), -1, &remove, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_finalize(insert);
+        sqlite3_finalize(update);
+        sqlite3_finalize(remove);
+        return false;
+    }
+
+    bool ok = true;
+    auto run = [&](sqlite3_stmt* stmt) {
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            std::cerr << "Write failed: " << sqlite3_errmsg(db) << std::endl;
+            ok = false;
+        }
+        sqlite3_reset(stmt);
+    };
+
+    for (size_t id = 0; id < groups.members.size() && ok; ++id) {
+        const std::string& value = groups.values.names[id];
+        std::string people = join_people(groups.members[id], names);
+
+        auto it = stored.find(value);
+        if (it == stored.end()) {
+            sqlite3_bind_text(insert, 1, value.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(insert, 2, people.c_str(), -1, SQLITE_TRANSIENT);
+            run(insert);
+            ++counts.inserted;
+            continue;
+        }
+
+        auto& rows = it->second;
+        if (rows.size() == 1 && rows[0].second == people) {
+            ++counts.unchanged;
+        } else {
+            sqlite3_bind_text(update, 1, people.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(update, 2, rows[0].first);
+            run(update);
+            ++counts.updated;
+
+            // extra rows for the same value are leftovers from older appends
+            for (size_t i = 1; i < rows.size(); ++i) {
+                sqlite3_bind_int64(remove, 1, rows[i].first);
+                run(remove);
+                ++counts.deleted;
+            }
+        }
+        stored.erase(it);
+    }
+
+    // whatever is left no longer has any members
+    for (const auto& group : stored) {
+        for (const auto& row : group.second) {
+            if (!ok) break;
+            sqlite3_bind_int64(remove, 1, row.first);
+            run(remove);
+            ++counts.deleted;
+        }
+    }
+
+    sqlite3_finalize(insert);
+    sqlite3_finalize(update);
+    sqlite3_finalize(remove);
+    return ok;
+}
+
+
+// Rewrites contact_organizations from the raw columns; organizations must be saved first.
+bool link_organizations(sqlite3* db, const std::map<std::string, EntityResolver>& resolvers,
+                        const std::vector<std::pair<sqlite3_int64, std::vector<std::string>>>& rawFields) {
+    if (!exec(db, "DELETE FROM contact_organizations;")) return false;
+
+    sqlite3_stmt* link;
+    if (sqlite3_prepare_v2(db, CONTACT_ORGANIZATION_INSERT, -1, &link, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    bool ok = true;
+    for (size_t c = 0; c < rawFields.size() && ok; ++c) {
+        for (int t = 0; t < GROUP_TABLE_COUNT && ok; ++t) {
+            if (!GROUP_TABLES[t].entity) continue;
+            ok = resolvers.at(GROUP_TABLES[t].entity).link(link, rawFields[c].first, GROUP_TABLES[t].source, rawFields[c].second[t]);
+        }
+    }
+    sqlite3_finalize(link);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    bool incremental = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--incremental") {
+            incremental = true;
+        } else {
+            std::cerr << "Usage: ./build_groups [--incremental]" << std::endl;
+            return 1;
+        }
+    }
+
+    sqlite3* db;
+    if (sqlite3_open("my_database.db", &db) != SQLITE_OK) {
+        std::cerr << "Error opening DB: " << sqlite3_errmsg(db) << std::endl;
+        return -1;
+    }
+
+    // one scan over employment and background feeds all five group kinds
+    std::string query = R"(
+        SELECT
+            contacts.name,
+            employment.current_company, employment.previous_companies, employment.industry,
+            background.college, background.high_school, contacts.id
+        FROM contacts
+        LEFT JOIN employment ON contacts.id = employment.contact_id
+        LEFT JOIN background ON contacts.id = background.contact_id
+        ORDER BY contacts.id;
+    )";
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Query error: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // rows imported before name resolution existed, or added through app.py, still get
+    // "Google LLC" folded into "Google"
+    std::map<std::string, EntityResolver> resolvers;
+    for (const char* kind : {"company", "school"}) {
+        auto it = resolvers.emplace(kind, EntityResolver(kind)).first;
+        if (!it->second.load(db)) {
+            sqlite3_finalize(stmt);
+            sqlite3_close(db);
+            return 1;
+        }
+    }
+
+    Interner names;
+    std::vector<Groups> groups(GROUP_TABLE_COUNT);
+    std::vector<std::pair<sqlite3_int64, std::vector<std::string>>> rawFields;  // contact id -> field per table
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        std::string name = getSafeText(stmt, 0);
+        if (name.empty()) continue;
+        uint32_t person = names.intern(name);
+        rawFields.emplace_back(sqlite3_column_int64(stmt, 6), std::vector<std::string>(GROUP_TABLE_COUNT));
+
+        // empty fields are skipped rather than lumped into an "unknown" group
+        for (int t = 0; t < GROUP_TABLE_COUNT; ++t) {
+            std::string field = getSafeText(stmt, GROUP_TABLES[t].field);
+            if (GROUP_TABLES[t].entity) {
+                rawFields.back().second[t] = field;
+                field = resolvers.at(GROUP_TABLES[t].entity).resolve_list(field);
+            }
+            for (const auto& value : split_values(field)) {
+                groups[t].add(value, person);
+            }
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    std::cout << "Scanned " << names.size() << " contacts." << std::endl;
+
+    for (int t = 0; t < GROUP_TABLE_COUNT; ++t) {
+        const GroupTable& g = GROUP_TABLES[t];
+        if (!exec(db, std::string("ATTACH DATABASE '") + g.dbFile + "' AS " + g.schema + ";")) {
+            sqlite3_close(db);
+            return 1;
+        }
+        // same shape as the matching .sql file, so a fresh checkout works without running adddb first
+        std::string create = std::string("CREATE TABLE IF NOT EXISTS ") + g.schema + "." + g.table + " ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT, " + g.column + " TEXT NOT NULL, people TEXT NOT NULL, "
+            "UNIQUE(" + g.column + ", people));";
+        if (!exec(db, create)) {
+            sqlite3_close(db);
+            return 1;
+        }
+    }
+
+    // all five files commit together or not at all
+    if (!exec(db, "BEGIN IMMEDIATE;")) {
+        sqlite3_close(db);
+        return 1;
+    }
+
+    bool ok = true;
+    for (auto& r : resolvers) ok = ok && r.second.save(db);
+    ok = ok && link_organizations(db, resolvers, rawFields);
+    for (int t = 0; t < GROUP_TABLE_COUNT && ok; ++t) {
+        WriteCounts counts;
+        ok = incremental ? update_table(db, GROUP_TABLES[t], groups[t], names, counts)
+                         : rebuild_table(db, GROUP_TABLES[t], groups[t], names, counts);
+
+        if (ok) {
+            std::cout << GROUP_TABLES[t].table << ": " << counts.inserted << " inserted, "
+                      << counts.updated << " updated, " << counts.deleted << " deleted, "
+                      << counts.unchanged << " unchanged" << std::endl;
+        }
+    }
+
+    if (!ok) {
+        exec(db, "ROLLBACK;");
+        sqlite3_close(db);
+        std::cerr << "Group rebuild failed, nothing was written." << std::endl;
+        return 1;
+    }
+
+    if (!exec(db, "COMMIT;")) {
+        sqlite3_close(db);
+        return 1;
+    }
+
+    sqlite3_close(db);
+    std::cout << "Groups rebuilt successfully!" << std::endl;
+    return 0;
+}
+
+
+/* to compile use this command
+
+gcc -c sqlite3.c -o sqlite3.o -I.
+g++ build_groups.cpp sqlite3.o -o build_groups -I.
+
+*/
@@ -0,0 +1,141 @@
+#ifndef CLI_OPTIONS_H
+#define CLI_OPTIONS_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Command line options shared by generate_edges and shared_text_engine. Extra arguments come in
+// as --key=value (app.py forwards a request's query string this way), a bare --key is "".
+
+
+inline std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) continue;
+
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            options[arg.substr(2)] = "";
+        } else {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    return options;
+}
+
+
+// --key=value as a number in [lo, hi], or fallback when the option is absent; false (with a
+// message) for anything else, so "--threshold=abc" is an error rather than 0
+inline bool number_option(const std::map<std::string, std::string> &options, const char *key, double fallback,
+                          double &value, double lo = -HUGE_VAL, double hi = HUGE_VAL) {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        value = fallback;
+        return true;
+    }
+
+    char *end = nullptr;
+    const std::string &text = it->second;
+    double parsed = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !std::isfinite(parsed) || parsed < lo || parsed > hi) {
+        std::cerr << "Bad --" << key << " value: " << text << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+
+// The options of one run, read with their defaults and checked as they are read. A bad value
+// is reported on stderr and clears ok(), so a caller reads all of its options and then gives
+// up once instead of carrying on with a 0:
+//   OptionReader option(options);
+//   size_t k = option.count("k", 20, 1);
+//   if (!option.ok()) return false;
+class OptionReader {
+public:
+    explicit OptionReader(const std::map<std::string, std::string> &options) : options_(options) {}
+
+    bool ok() const { return ok_; }
+    bool has(const char *key) const { return options_.count(key) > 0; }
+
+    double number(const char *key, double fallback, double lo = -HUGE_VAL, double hi = HUGE_VAL) {
+        double value = fallback;
+        ok_ = number_option(options_, key, fallback, value, lo, hi) && ok_;
+        return value;
+    }
+
+    // a whole number in [lo, hi]
+    size_t count(const char *key, size_t fallback, size_t lo = 0, size_t hi = UINT32_MAX) {
+        double value = number(key, static_cast<double>(fallback), static_cast<double>(lo), static_cast<double>(hi));
+        if (value != std::floor(value)) {
+            std::cerr << "Bad --" << key << " value (expected a whole number): " << options_.at(key) << std::endl;
+            ok_ = false;
+            return fallback;
+        }
+        return static_cast<size_t>(value);
+    }
+
+    // comma separated contact ids, e.g. --update=12,40; every one must be a whole number >= 1
+    std::vector<int> ids(const char *key) {
+        std::vector<int> out;
+        auto it = options_.find(key);
+        if (it == options_.end()) return out;
+
+        std::stringstream ss(it->second);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t first = item.find_first_not_of(" \t");
+            if (first == std::string::npos) continue;
+            item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+
+            char *end = nullptr;
+            long id = std::strtol(item.c_str(), &end, 10);
+            if (*end != '\0' || id < 1 || id > INT32_MAX) {
+                std::cerr << "Bad --" << key << " id: " << item << std::endl;
+                ok_ = false;
+                continue;
+            }
+            out.push_back(static_cast<int>(id));
+        }
+        if (out.empty() && ok_) {
+            std::cerr << "--" << key << " needs at least one contact id" << std::endl;
+            ok_ = false;
+        }
+        return out;
+    }
+
+    std::string text(const char *key, const std::string &fallback) const {
+        auto it = options_.find(key);
+        return it == options_.end() ? fallback : it->second;
+    }
+
+    // one of choices, the first being the default
+    std::string choice(const char *key, std::initializer_list<const char *> choices) {
+        std::string value = text(key, *choices.begin());
+        for (const char *c : choices) {
+            if (value == c) return value;
+        }
+        std::string expected;
+        for (const char *c : choices) expected += (expected.empty() ? "" : ", ") + std::string(c);
+        std::cerr << "Unknown --" << key << " " << value << ", expected " << expected << std::endl;
+        ok_ = false;
+        return *choices.begin();
+    }
+
+private:
+    const std::map<std::string, std::string> &options_;
+    bool ok_ = true;
+};
+
+#endif
@@ -0,0 +1,510 @@
+#ifndef ENTITY_RESOLUTION_H
+#define ENTITY_RESOLUTION_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sqlite3.h"
+#include "text_normalize.h"
+
+// Resolves organization names ("Google", "Google LLC", "google inc.") to one canonical
+// organization, so groups built on company and school names don't fragment.
+//
+// Only the rules merge: lowercase, punctuation out, "&" -> "and", legal suffixes (inc, llc,
+// ltd, ...) and a dangling "and" off. Most variants already meet here as the same key.
+//
+// Anything else is a new organization. Near misses are only suggested, never merged, since
+// "Northwestern" and "Northeastern" are one edit apart:
+//   1. blocking: the key's character trigrams pick the organizations that could be within the
+//      allowed edit distance (q-gram lemma: k edits destroy at most 3k trigrams).
+//   2. Myers' bit-parallel edit distance on just those, one machine word per step.
+//
+// Organizations, every alias seen and the suggestions are kept in my_database.db, so each
+// spelling is resolved once and the canonical id is stable. contact_organizations links each
+// contact to the organizations in its raw company and school columns, which stay as typed.
+
+const char* ENTITY_SCHEMA = R"(
+    CREATE TABLE IF NOT EXISTS organizations (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        kind TEXT NOT NULL,
+        name TEXT NOT NULL
+    );
+    CREATE TABLE IF NOT EXISTS organization_aliases (
+        kind TEXT NOT NULL,
+        alias TEXT NOT NULL,
+        organization_id INTEGER NOT NULL,
+        PRIMARY KEY (kind, alias),
+        FOREIGN KEY(organization_id) REFERENCES organizations(id)
+    );
+    CREATE TABLE IF NOT EXISTS organization_suggestions (
+        kind TEXT NOT NULL,
+        alias TEXT NOT NULL,
+        organization_id INTEGER NOT NULL,
+        distance INTEGER NOT NULL,
+        PRIMARY KEY (kind, alias),
+        FOREIGN KEY(organization_id) REFERENCES organizations(id)
+    );
+    CREATE TABLE IF NOT EXISTS contact_organizations (
+        contact_id INTEGER NOT NULL,
+        field TEXT NOT NULL,
+        position INTEGER NOT NULL,
+        organization_id INTEGER NOT NULL,
+        PRIMARY KEY (contact_id, field, position),
+        FOREIGN KEY(contact_id) REFERENCES contacts(id),
+        FOREIGN KEY(organization_id) REFERENCES organizations(id)
+    );
+)";
+
+const char* CONTACT_ORGANIZATION_INSERT =
+    "INSERT OR REPLACE INTO contact_organizations (contact_id, field, position, organization_id) VALUES (?, ?, ?, ?);";
+
+// SQL for one contact column read through contact_organizations: the canonical names joined
+// with ", ", or the raw column for contacts that were never resolved.
+//   canonical_column("employment.current_company", "current_company")
+inline std::string canonical_column(const std::string& column, const std::string& field) {
+    return "COALESCE((SELECT group_concat(name, ', ') FROM (SELECT o.name AS name FROM contact_organizations co "
+           "JOIN organizations o ON o.id = co.organization_id "
+           "WHERE co.contact_id = contacts.id AND co.field = '" + field + "' ORDER BY co.position)), " + column + ")";
+}
+
+// true once import_contacts or build_groups has created the organization tables, which readers
+// opening the database read-only cannot do themselves
+inline bool has_organization_tables(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' "
+                               "AND name IN ('organizations', 'contact_organizations');", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool found = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) == 2;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// words dropped from the end of a company name
+const std::set<std::string> COMPANY_SUFFIXES = {
+    "inc", "incorporated", "llc", "ltd", "limited", "corp", "corporation", "co", "company", "plc",
+    "gmbh", "ag", "sa", "lp", "llp", "pllc", "pte", "pty", "bv", "nv", "srl"
+};
+
+// school abbreviations spelled out, so "Stanford Univ." and "Stanford University" meet
+const std::unordered_map<std::string, std::string> SCHOOL_WORDS = {
+    {"univ", "university"}, {"uni", "university"}, {"u", "university"}, {"coll", "college"},
+    {"hs", "high school"}, {"inst", "institute"}, {"tech", "technology"}
+};
+
+// connectors left dangling once a suffix is gone ("Bain & Company" -> "Bain &")
+const std::set<std::string> TRAILING_CONNECTORS = {"and", "&"};
+
+// a near miss is only suggested when every edit falls inside a word at least this long;
+// in shorter words one letter is another name ("Carlson" / "Clemson")
+const size_t MIN_FUZZY_WORD = 8;
+
+
+// Levenshtein distance with the pattern packed into one 64-bit word (Myers 1999, in Hyyrö's
+// formulation). Longer patterns fall back to the row-by-row table.
+class MyersPattern {
+public:
+    explicit MyersPattern(const std::string &pattern) : pattern_(pattern) {
+        if (pattern.size() > 64 || pattern.empty()) return;
+        std::memset(peq_, 0, sizeof(peq_));
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            peq_[static_cast<unsigned char>(pattern[i])] |= 1ull << i;
+        }
+    }
+
+    int distance(const std::string &text) const {
+        size_t m = pattern_.size();
+        if (m == 0) return static_cast<int>(text.size());
+        if (m > 64) return table_distance(text);
+
+        uint64_t pv = ~0ull, mv = 0;
+        uint64_t last = 1ull << (m - 1);
+        int score = static_cast<int>(m);
+
+        for (unsigned char c : text) {
+            uint64_t eq = peq_[c];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if (ph & last) ++score;
+            else if (mh & last) --score;
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+        return score;
+    }
+
+private:
+    int table_distance(const std::string &text) const {
+        std::vector<int> row(text.size() + 1);
+        for (size_t j = 0; j <= text.size(); ++j) row[j] = static_cast<int>(j);
+        for (size_t i = 1; i <= pattern_.size(); ++i) {
+            int diagonal = row[0];
+            row[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= text.size(); ++j) {
+                int up = row[j];
+                row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (pattern_[i - 1] != text[j - 1])});
+                diagonal = up;
+            }
+        }
+        return row[text.size()];
+    }
+
+    std::string pattern_;
+    uint64_t peq_[256];
+};
+
+
+class EntityResolver {
+public:
+    // kind is "company" or "school"; each kind is its own namespace
+    explicit EntityResolver(const std::string &kind) : kind_(kind) {}
+
+    size_t size() const { return orgs_.size(); }
+
+    // Comparison key: lowercased words without punctuation or legal suffixes.
+    std::string key_of(const std::string &name) const {
+        std::string cleaned;
+        for (char ch : name) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (ch == '&') cleaned += " and ";
+            else if (std::isalnum(c) || c >= 0x80) cleaned.push_back(static_cast<char>(std::tolower(c)));
+            else if (ch != '\'' && ch != '.') cleaned.push_back(' ');  // "l.l.c." -> "llc"
+        }
+
+        std::vector<std::string> words;
+        std::stringstream ss(cleaned);
+        std::string word;
+        while (ss >> word) words.push_back(word);
+
+        if (!words.empty() && words.front() == "the") words.erase(words.begin());
+        if (kind_ == "company") {
+            while (words.size() > 1 && (COMPANY_SUFFIXES.count(words.back()) || TRAILING_CONNECTORS.count(words.back()))) {
+                words.pop_back();
+            }
+        } else {
+            for (auto &w : words) {
+                auto it = SCHOOL_WORDS.find(w);
+                if (it != SCHOOL_WORDS.end()) w = it->second;
+            }
+        }
+
+        std::string key;
+        for (const auto &w : words) key += (key.empty() ? "" : " ") + w;
+        return key;
+    }
+
+    // Loads this kind's organizations and aliases; creates the tables on first use.
+    bool load(sqlite3 *db) {
+        char *errorMessage = nullptr;
+        if (sqlite3_exec(db, ENTITY_SCHEMA, nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+            std::cerr << "SQL error: " << errorMessage << std::endl;
+            sqlite3_free(errorMessage);
+            return false;
+        }
+
+        sqlite3_stmt *stmt;
+        std::unordered_map<sqlite3_int64, uint32_t> byId;
+        if (sqlite3_prepare_v2(db, "SELECT id, name FROM organizations WHERE kind = ? ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        sqlite3_bind_text(stmt, 1, kind_.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char *name = sqlite3_column_text(stmt, 1);
+            uint32_t org = add_org(name ? reinterpret_cast<const char *>(name) : "");
+            orgs_[org].id = sqlite3_column_int64(stmt, 0);
+            byId[orgs_[org].id] = org;
+        }
+        sqlite3_finalize(stmt);
+
+        if (sqlite3_prepare_v2(db, "SELECT alias, organization_id FROM organization_aliases WHERE kind = ?;", -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        sqlite3_bind_text(stmt, 1, kind_.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char *alias = sqlite3_column_text(stmt, 0);
+            auto org = byId.find(sqlite3_column_int64(stmt, 1));
+            if (alias && org != byId.end()) aliases_[reinterpret_cast<const char *>(alias)] = org->second;
+        }
+        sqlite3_finalize(stmt);
+        pendingAliases_.clear();
+        pendingSuggestions_.clear();
+        return true;
+    }
+
+    // Canonical name for one raw name ("" for an empty one). An unknown spelling becomes an
+    // alias of the organization with the same key, or a new organization; when an existing one
+    // is a few edits away that is recorded as a suggestion for someone to confirm.
+    const std::string &resolve(const std::string &raw) {
+        static const std::string empty;
+        std::string alias = normalize_value(raw);
+        if (alias.empty()) return empty;
+
+        auto known = aliases_.find(alias);
+        if (known != aliases_.end()) return orgs_[known->second].name;
+
+        std::string key = key_of(raw);
+        int org = -1;
+        auto exact = byKey_.find(key);
+        if (exact != byKey_.end()) {
+            org = static_cast<int>(exact->second);
+        } else if (!key.empty()) {
+            int distance = 0;
+            int near = find_near(key, distance);
+            org = static_cast<int>(add_org(display_name(raw)));
+            if (near >= 0) pendingSuggestions_.push_back({alias, static_cast<uint32_t>(near), distance});
+        } else {
+            org = static_cast<int>(add_org(display_name(raw)));
+        }
+
+        aliases_[alias] = static_cast<uint32_t>(org);
+        pendingAliases_.push_back(alias);
+        return orgs_[org].name;
+    }
+
+    // canonical id of a name resolved earlier (0 until save() has run for a new organization)
+    sqlite3_int64 organization_id(const std::string &raw) const {
+        auto it = aliases_.find(normalize_value(raw));
+        return it == aliases_.end() ? 0 : orgs_[it->second].id;
+    }
+
+    // organizations of each comma separated item, in order and without repeats; the items must
+    // have been resolved and saved
+    std::vector<sqlite3_int64> organization_ids(const std::string &field) const {
+        std::vector<sqlite3_int64> ids;
+        std::stringstream ss(field);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            sqlite3_int64 id = organization_id(item);
+            if (id != 0 && std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+        }
+        return ids;
+    }
+
+    // Writes one contact's contact_organizations rows for field through a prepared
+    // CONTACT_ORGANIZATION_INSERT; the caller clears old rows and owns the transaction.
+    bool link(sqlite3_stmt *insert, sqlite3_int64 contactId, const std::string &fieldName, const std::string &field) const {
+        std::vector<sqlite3_int64> ids = organization_ids(field);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            sqlite3_bind_int64(insert, 1, contactId);
+            sqlite3_bind_text(insert, 2, fieldName.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(insert, 3, static_cast<sqlite3_int64>(i));
+            sqlite3_bind_int64(insert, 4, ids[i]);
+            bool ok = sqlite3_step(insert) == SQLITE_DONE;
+            sqlite3_reset(insert);
+            if (!ok) {
+                std::cerr << "Organization link failed: " << sqlite3_errmsg(sqlite3_db_handle(insert)) << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // each comma separated item resolved, duplicates after resolution dropped
+    std::string resolve_list(const std::string &field) {
+        std::string joined;
+        std::set<std::string> seen;
+        std::stringstream ss(field);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            const std::string &name = resolve(item);
+            if (name.empty() || !seen.insert(normalize_value(name)).second) continue;
+            joined += (joined.empty() ? "" : ", ") + name;
+        }
+        return joined;
+    }
+
+    // Writes organizations, aliases and suggestions added since load(); caller owns the transaction.
+    bool save(sqlite3 *db) {
+        sqlite3_stmt *org = nullptr, *alias = nullptr, *suggestion = nullptr;
+        if (sqlite3_prepare_v2(db, "INSERT INTO organizations (kind, name) VALUES (?, ?);", -1, &org, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO organization_aliases (kind, alias, organization_id) VALUES (?, ?, ?);", -1, &alias, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO organization_suggestions (kind, alias, organization_id, distance) VALUES (?, ?, ?, ?);", -1, &suggestion, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_finalize(org);
+            sqlite3_finalize(alias);
+            return false;
+        }
+
+        bool ok = true;
+        for (auto &o : orgs_) {
+            if (o.id != 0 || !ok) continue;
+            sqlite3_bind_text(org, 1, kind_.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(org, 2, o.name.c_str(), -1, SQLITE_TRANSIENT);
+            ok = sqlite3_step(org) == SQLITE_DONE;
+            o.id = sqlite3_last_insert_rowid(db);
+            sqlite3_reset(org);
+        }
+        for (const auto &a : pendingAliases_) {
+            if (!ok) break;
+            sqlite3_bind_text(alias, 1, kind_.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(alias, 2, a.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(alias, 3, orgs_[aliases_[a]].id);
+            ok = sqlite3_step(alias) == SQLITE_DONE;
+            sqlite3_reset(alias);
+        }
+        for (const auto &s : pendingSuggestions_) {
+            if (!ok) break;
+            sqlite3_bind_text(suggestion, 1, kind_.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(suggestion, 2, s.alias.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(suggestion, 3, orgs_[s.org].id);
+            sqlite3_bind_int(suggestion, 4, s.distance);
+            ok = sqlite3_step(suggestion) == SQLITE_DONE;
+            sqlite3_reset(suggestion);
+        }
+        if (!ok) {
+            std::cerr << "Alias write failed: " << sqlite3_errmsg(db) << std::endl;
+        } else {
+            pendingAliases_.clear();
+            pendingSuggestions_.clear();
+        }
+
+        sqlite3_finalize(org);
+        sqlite3_finalize(alias);
+        sqlite3_finalize(suggestion);
+        return ok;
+    }
+
+private:
+    struct Organization {
+        sqlite3_int64 id;            // 0 until saved
+        std::string name;            // display name
+        std::string key;
+        uint32_t trigrams;           // distinct trigrams in key
+    };
+
+    struct Suggestion {
+        std::string alias;
+        uint32_t org;
+        int distance;
+    };
+
+    // edits allowed for a key of this length: none for short names, where one letter is a
+    // different company ("meta" / "beta"), then one per six characters
+    static int max_distance(size_t length) { return static_cast<int>(std::min<size_t>(length / 6, 3)); }
+
+    static std::vector<uint32_t> trigrams_of(const std::string &key) {
+        std::string padded = "^" + key + "$";
+        std::vector<uint32_t> grams;
+        for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+            grams.push_back((static_cast<uint32_t>(static_cast<unsigned char>(padded[i])) << 16) |
+                            (static_cast<uint32_t>(static_cast<unsigned char>(padded[i + 1])) << 8) |
+                            static_cast<unsigned char>(padded[i + 2]));
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+
+    // true when the keys have the same words and each word that differs is long enough that a
+    // few edits are more likely a typo than another name
+    static bool edits_in_long_words(const std::string &a, const std::string &b) {
+        std::stringstream sa(a), sb(b);
+        std::string wa, wb;
+        while (true) {
+            bool moreA = static_cast<bool>(sa >> wa), moreB = static_cast<bool>(sb >> wb);
+            if (moreA != moreB) return false;
+            if (!moreA) return true;
+            if (wa != wb && std::min(wa.size(), wb.size()) < MIN_FUZZY_WORD) return false;
+        }
+    }
+
+    // the raw name minus trailing legal suffixes and connectors, keeping its own capitalization
+    std::string display_name(const std::string &raw) const {
+        std::vector<std::string> words;
+        std::stringstream ss(raw);
+        std::string word;
+        while (ss >> word) words.push_back(word);
+
+        while (kind_ == "company" && words.size() > 1) {
+            std::string bare;
+            for (char ch : words.back()) {
+                if (std::isalnum(static_cast<unsigned char>(ch))) bare.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+            }
+            if (!COMPANY_SUFFIXES.count(bare) && !TRAILING_CONNECTORS.count(bare.empty() ? words.back() : bare)) break;
+            words.pop_back();
+        }
+
+        std::string name;
+        for (const auto &w : words) name += (name.empty() ? "" : " ") + w;
+        while (!name.empty() && (name.back() == ',' || name.back() == '.')) name.pop_back();
+        return name;
+    }
+
+    uint32_t add_org(const std::string &name) {
+        Organization o;
+        o.id = 0;
+        o.name = name;
+        o.key = key_of(name);
+        std::vector<uint32_t> grams = trigrams_of(o.key);
+        o.trigrams = static_cast<uint32_t>(grams.size());
+
+        uint32_t index = static_cast<uint32_t>(orgs_.size());
+        orgs_.push_back(o);
+        byKey_.emplace(o.key, index);
+        for (uint32_t g : grams) postings_[g].push_back(index);
+        return index;
+    }
+
+    // closest organization within a few edits of key (whose exact key is unknown), or -1
+    int find_near(const std::string &key, int &distance) {
+        int k = max_distance(key.size());
+        if (k == 0) return -1;
+
+        std::vector<uint32_t> grams = trigrams_of(key);
+        if (shared_.size() < orgs_.size()) shared_.resize(orgs_.size(), 0);
+
+        for (uint32_t g : grams) {
+            auto posting = postings_.find(g);
+            if (posting == postings_.end()) continue;
+            for (uint32_t org : posting->second) {
+                if (shared_[org]++ == 0) touched_.push_back(org);
+            }
+        }
+
+        MyersPattern pattern(key);
+        int best = -1, bestDistance = k + 1;
+        for (uint32_t org : touched_) {
+            const Organization &o = orgs_[org];
+            int need = static_cast<int>(std::max<size_t>(grams.size(), o.trigrams)) - 3 * k;
+            bool close = static_cast<int>(shared_[org]) >= need &&
+                         static_cast<int>(o.key.size()) - static_cast<int>(key.size()) <= k &&
+                         static_cast<int>(key.size()) - static_cast<int>(o.key.size()) <= k;
+            shared_[org] = 0;
+            if (!close || !edits_in_long_words(key, o.key)) continue;
+
+            int d = pattern.distance(o.key);
+            if (d < bestDistance || (d == bestDistance && static_cast<int>(org) < best)) {
+                bestDistance = d;
+                best = static_cast<int>(org);
+            }
+        }
+        touched_.clear();
+        distance = bestDistance;
+        return best;
+    }
+
+    std::string kind_;
+    std::vector<Organization> orgs_;
+    std::unordered_map<std::string, uint32_t> byKey_;                 // key -> organization
+    std::unordered_map<std::string, uint32_t> aliases_;               // normalized raw name -> organization
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;    // trigram -> organizations
+    std::vector<std::string> pendingAliases_;                         // aliases not yet in the db
+    std::vector<Suggestion> pendingSuggestions_;                      // near misses not yet in the db
+    std::vector<uint32_t> shared_;                                    // scratch: trigram hits per organization
+    std::vector<uint32_t> touched_;
+};
+
+#endif
@@ -3,10 +3,24 @@
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
+#include "pair_map.h"
+#include "text_normalize.h"
+#include "thread_pool.h"
+#include "hnsw_index.h"
+#include "graph_algorithms.h"
+#include "entity_resolution.h"
+#include "cli_options.h"
 #include <tuple>
 #include <sstream>
 #include <curl/curl.h>
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <algorithm>
 
 using json = nlohmann::json;
@@ -29,6 +43,10 @@ struct entry {
     std::string careerGoals;
     std::string skills;
     std::string talent;
+
+    std::string interests;
+    std::string college;
+    std::string highSchool;
 };
 
 struct GeoEntry {
@@ -62,11 +80,9 @@ std::string getSafeText(sqlite3_stmt* stmt, int col) {
     return text ? reinterpret_cast<const char*>(text) : "";
 }
 
-std::string buffer;  // Global buffer for simplicity
-
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t realSize = size * nmemb;
-    buffer.append((char*)contents, realSize);
+    static_cast<std::string*>(userp)->append((char*)contents, realSize);
     return realSize;
 }
 
@@ -86,11 +102,12 @@ bool get_lat_lon(const std::string& location, double& lat, double& lon) {
     std::string url = "https://api.opencagedata.com/geocode/v1/json?q=" + std::string(escaped) + "&key=" + api_key;
     curl_free(escaped); 
 
-    buffer.clear(); 
+    // per call rather than global, views can geocode from several threads
+    std::string buffer;
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, nullptr);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
 
     // Disable SSL verification for local testing
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
@@ -139,6 +156,121 @@ PixelPosition geo_to_scrollable_pixel(double lat, double lon,
     return {x, y};
 }
 
+// attributes a parent is matched on, prefixed so a company and a skill with the same text don't collide
+std::vector<std::string> parent_match_keys(const entry &e) {
+    std::vector<std::string> keys;
+
+    std::string location = normalize_value(e.location);
+    if (!location.empty()) keys.push_back("location: " + location);
+    for (const auto &company : split_values(e.currCompany)) keys.push_back("company: " + company);
+    for (const auto &skill : split_values(e.skills)) keys.push_back("skills: " + skill);
+
+    return keys;
+}
+
+
+// blue directional edges: each person hangs off the most similar person in the nearest higher
+// level that has anyone sharing a location, company or skill with them, looking further up when
+// the level right above shares nothing. Every level gets an inverted index (attribute -> people
+// in that level), so scoring a person only walks the posting lists of their own attributes
+// instead of the whole level above. People who share nothing with anyone above are spread over
+// the nearest non-empty level, each going to its least-loaded parent, with an empty label.
+void link_to_similar_parents(json &result, std::map<int, std::vector<entry>> &levelMap,
+                             std::map<std::string, int> &nameToId) {
+    std::map<int, std::unordered_map<std::string, std::vector<size_t>>> levelIndex;
+
+    for (int level = 1; level <= 10; ++level) {
+        const auto &people = levelMap[level];
+        auto &index = levelIndex[level];
+        for (size_t i = 0; i < people.size(); ++i) {
+            for (const auto &key : parent_match_keys(people[i])) {
+                auto &posting = index[key];
+                if (posting.empty() || posting.back() != i) posting.push_back(i);
+            }
+        }
+    }
+
+    std::unordered_map<int, size_t> children;  // parent id -> blue edges so far
+    auto link = [&](const entry &parent, int myId, const std::string &label) {
+        int parentId = nameToId[parent.name];
+        ++children[parentId];
+        result["edges"].push_back({
+            {"source", parentId},
+            {"target", myId},
+            {"color", "blue"},
+            {"label", label}
+        });
+    };
+
+    for (int level = 10; level >= 1; --level) {
+        const auto &people = levelMap[level];
+
+        for (const auto &person : people) {
+            int myId = nameToId[person.name];
+            bool linked = false;
+            int nearest = 0;  // closest higher level with someone else in it
+            std::vector<std::string> keys = parent_match_keys(person);
+
+            for (int hl = level + 1; hl <= 10 && !linked; ++hl) {
+                const auto &higher = levelMap[hl];
+                if (higher.empty()) continue;
+                if (nearest == 0 && (higher.size() > 1 || higher[0].name != person.name)) nearest = hl;
+
+                const auto &index = levelIndex[hl];
+                std::unordered_map<size_t, int> score;
+                for (const auto &key : keys) {
+                    auto it = index.find(key);
+                    if (it == index.end()) continue;
+                    for (size_t candidate : it->second) ++score[candidate];
+                }
+
+                // best score wins, ties go to the earlier entry; nobody sharing a key means try the next level
+                size_t best = higher.size();
+                int bestScore = 0;
+                for (const auto &s : score) {
+                    if (higher[s.first].name == person.name) continue;
+                    if (s.second > bestScore || (s.second == bestScore && s.first < best)) {
+                        best = s.first;
+                        bestScore = s.second;
+                    }
+                }
+                if (best == higher.size()) continue;
+
+                std::vector<std::string> parentKeys = parent_match_keys(higher[best]);
+                std::set<std::string> parentSet(parentKeys.begin(), parentKeys.end());
+                std::string label;
+                for (const auto &key : keys) {
+                    if (parentSet.count(key)) label += (label.empty() ? "" : ", ") + key;
+                }
+
+                link(higher[best], myId, label);
+                linked = true;
+            }
+
+            if (!linked && nearest > 0) {
+                const auto &higher = levelMap[nearest];
+                size_t best = higher.size();
+                for (size_t i = 0; i < higher.size(); ++i) {
+                    if (higher[i].name == person.name) continue;
+                    if (best == higher.size() || children[nameToId[higher[i].name]] < children[nameToId[higher[best].name]]) best = i;
+                }
+                link(higher[best], myId, "");
+                linked = true;
+            }
+
+            // if no higher level node, link to root
+            if (!linked && level == 10) {
+                result["edges"].push_back({
+                    {"source", 0},
+                    {"target", myId},
+                    {"color", "blue"}
+                });
+            }
+        }
+    }
+}
+
+
 json generate_edges_by_default(const std::vector<entry>& entries) {
     // default
     json result;
@@ -153,8 +285,6 @@ json generate_edges_by_default(const std::vector<entry>& entries) {
 
     result["edges"] = json::array();  // no edges yet
 
-    std::cout << result.dump(2) << std::endl;
-
     return result;
 }
 
@@ -204,7 +334,7 @@ json generate_edges_by_talent(const std::vector<entry>& entries) {
         }
     }
 
-    // red bidirectional edges for same location, same level
+    // red undirected edges for same location, same level
     for (int level = 10; level >= 1; --level) {
         const auto& people = talentMap[level];
         for (size_t i = 0; i < people.size(); ++i) {
@@ -212,48 +342,14 @@ json generate_edges_by_talent(const std::vector<entry>& entries) {
                 if (people[i].location == people[j].location && people[i].name != people[j].name) {
                     int id1 = nameToId[people[i].name];
                     int id2 = nameToId[people[j].name];
-                    result["edges"].push_back({{"source", id1}, {"target", id2}, {"color", "red"}});
-                    result["edges"].push_back({{"source", id2}, {"target", id1}, {"color", "red"}});
+                    result["edges"].push_back({{"source", id1}, {"target", id2}, {"color", "red"}, {"undirected", true}});
                 }
             }
         }
     }
 
-    // blue directional edges to nearest higher-level node
-    for (int level = 10; level >= 1; --level) {
-        const auto& people = talentMap[level];
-        for (const auto& person : people) {
-            int myId = nameToId[person.name];
-            bool linked = false;
-
-            for (int hl = level + 1; hl <= 10 && !linked; ++hl) {
-                if (!talentMap.count(hl)) continue;
-
-                for (const auto& higher : talentMap[hl]) {
-                    if (higher.name == person.name) continue;
-                    int higherId = nameToId[higher.name];
-                    result["edges"].push_back({
-                        {"source", higherId},
-                        {"target", myId},
-                        {"color", "blue"}
-                    });
-                    linked = true;
-                    break;
-                }
-            }
-
-            // if no higher level node, link to root
-            if (!linked && level == 10) {
-                result["edges"].push_back({
-                    {"source", 0},
-                    {"target", myId},
-                    {"color", "blue"}
-                });
-            }
-        }
-    }
+    link_to_similar_parents(result, talentMap, nameToId);
 
-    std::cout << result.dump(2) << std::endl;
     return result;
 }
 
@@ -303,7 +399,7 @@ json generate_edges_by_closeness(const std::vector<entry>& entries) {
         }
     }
 
-    // red bidirectional edges for same location
+    // red undirected edges for same location
     for (int level = 10; level >= 1; --level) {
         const auto& people = closenessMap[level];
         for (size_t i = 0; i < people.size(); ++i) {
@@ -311,48 +407,14 @@ json generate_edges_by_closeness(const std::vector<entry>& entries) {
                 if (people[i].location == people[j].location && people[i].name != people[j].name) {
                     int id1 = nameToId[people[i].name];
                     int id2 = nameToId[people[j].name];
-                    result["edges"].push_back({{"source", id1}, {"target", id2}, {"color", "red"}});
-                    result["edges"].push_back({{"source", id2}, {"target", id1}, {"color", "red"}});
+                    result["edges"].push_back({{"source", id1}, {"target", id2}, {"color", "red"}, {"undirected", true}});
                 }
             }
         }
     }
 
-    // blue directional edges to nearest higher-level node
-    for (int level = 10; level >= 1; --level) {
-        const auto& people = closenessMap[level];
-        for (const auto& person : people) {
-            int myId = nameToId[person.name];
-            bool linked = false;
-
-            for (int hl = level + 1; hl <= 10 && !linked; ++hl) {
-                if (!closenessMap.count(hl)) continue;
-
-                for (const auto& higher : closenessMap[hl]) {
-                    if (higher.name == person.name) continue;
-                    int higherId = nameToId[higher.name];
-                    result["edges"].push_back({
-                        {"source", higherId},
-                        {"target", myId},
-                        {"color", "blue"}
-                    });
-                    linked = true;
-                    break;
-                }
-            }
-
-            // if no higher node, link to root
-            if (!linked && level == 10) {
-                result["edges"].push_back({
-                    {"source", 0},
-                    {"target", myId},
-                    {"color", "blue"}
-                });
-            }
-        }
-    }
+    link_to_similar_parents(result, closenessMap, nameToId);
 
-    std::cout << result.dump(2) << std::endl;
     return result;
 }
 
@@ -410,8 +472,6 @@ json generate_edges_by_location(const std::vector<entry>& entries) {
         });
     }    
 
-    std::cout << result.dump(2) << std::endl;
-    
     return result;
 }
 
@@ -432,18 +492,46 @@ std::vector<std::string> split_people(const std::string &peopleStr) {
 }
 
 
-json generate_edges_by_college(const std::string &db_path = "college_groups.db") {
+// one edge per pair; the pair's labels are joined into "label" for the tooltip
+void append_labeled_edges(json &result, const PairMap<EdgeLabels> &pairs,
+                          const Interner &people, const Interner &labels) {
+    for (uint64_t key : pairs.sorted_keys()) {
+        const EdgeLabels &pairLabels = *pairs.find(key);
+
+        json labelList = json::array();
+        std::string label;
+        for (uint32_t i = 0; i < pairLabels.size(); ++i) {
+            const std::string &text = labels.names[pairLabels.at(i)];
+            labelList.push_back(text);
+            label += (label.empty() ? "" : ", ") + text;
+        }
+
+        result["edges"].push_back({
+            {"source", people.names[pair_first(key)]},
+            {"target", people.names[pair_second(key)]},
+            {"label", label},
+            {"labels", labelList},
+            {"undirected", true}
+        });
+    }
+}
+
+
+// shared by the *_groups views: each row is (group value, comma separated people).
+// Pairs are aggregated before output, so two people in several groups (or listed twice in
+// one, which UNIQUE(college, people) doesn't prevent) still get a single edge.
+json generate_edges_from_groups(const std::string &db_path, const char *query) {
     json result;
     result["nodes"] = json::array();
     result["edges"] = json::array();
 
     sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+    // read-only and private to this call, so several views can build at once
+    if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
         std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
         return result;
     }
 
-    const char *query = "SELECT college, people FROM college_groups;";
     sqlite3_stmt *stmt;
 
     if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
@@ -452,60 +540,54 @@ json generate_edges_by_college(const std::string &db_path = "college_groups.db")
         return result;
     }
 
-    std::set<std::string> unique_nodes;
+    Interner people;
+    Interner labels;
+    PairMap<EdgeLabels> pairs;
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string college = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string people_str = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-
-        std::vector<std::string> people = split_people(people_str);
+        uint32_t labelId = labels.intern(getSafeText(stmt, 0));
 
-        // Add nodes
-        for (const auto &person : people) {
-            if (unique_nodes.insert(person).second) {
-                result["nodes"].push_back({{"id", person}});
-            }
+        std::vector<uint32_t> members;
+        for (const auto &person : split_people(getSafeText(stmt, 1))) {
+            members.push_back(people.intern(person));
         }
+        std::sort(members.begin(), members.end());
+        members.erase(std::unique(members.begin(), members.end()), members.end());
 
-        // Add edges for all combinations if more than one person
-        for (size_t i = 0; i < people.size(); ++i) {
-            for (size_t j = i + 1; j < people.size(); ++j) {
-                result["edges"].push_back({
-                    {"source", people[i]},
-                    {"target", people[j]},
-                    {"label", college}
-                });
-                result["edges"].push_back({
-                    {"source", people[j]},
-                    {"target", people[i]},
-                    {"label", college}
-                });
+        for (size_t i = 0; i < members.size(); ++i) {
+            for (size_t j = i + 1; j < members.size(); ++j) {
+                pairs[pair_key(members[i], members[j])].add(labelId);
             }
         }
     }
 
     sqlite3_finalize(stmt);
     sqlite3_close(db);
-    
-    std::cout << result.dump(2) << std::endl;
 
-    return result;
+    for (const auto &person : people.names) {
+        result["nodes"].push_back({{"id", person}});
+    }
+
+    append_labeled_edges(result, pairs, people, labels);
 
+    return result;
 }
 
 
-json generate_edges_by_high_school(const std::string &db_path = "highschool_groups.db") {
+// shared by the pair-table views: each row is (person1, person2, what they share).
+// (a, b) and (b, a) rows fold into one edge carrying both labels.
+json generate_edges_from_pair_table(const std::string &db_path, const char *query) {
     json result;
     result["nodes"] = json::array();
     result["edges"] = json::array();
 
     sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
+    // read-only and private to this call, so several views can build at once
+    if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
         std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
         return result;
     }
 
-    const char *query = "SELECT highschool, people FROM highschool_groups;";
     sqlite3_stmt *stmt;
 
     if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
@@ -514,419 +596,1649 @@ json generate_edges_by_high_school(const std::string &db_path = "highschool_grou
         return result;
     }
 
-    std::set<std::string> unique_nodes;
+    Interner people;
+    Interner labels;
+    PairMap<EdgeLabels> pairs;
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string high_school = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string people_str = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-
-        std::vector<std::string> people = split_people(people_str);
-
-        // Add nodes
-        for (const auto &person : people) {
-            if (unique_nodes.insert(person).second) {
-                result["nodes"].push_back({{"id", person}});
-            }
-        }
+        uint32_t person1 = people.intern(getSafeText(stmt, 0));
+        uint32_t person2 = people.intern(getSafeText(stmt, 1));
+        if (person1 == person2) continue;
 
-        // Add edges for all combinations if more than one person
-        for (size_t i = 0; i < people.size(); ++i) {
-            for (size_t j = i + 1; j < people.size(); ++j) {
-                result["edges"].push_back({
-                    {"source", people[i]},
-                    {"target", people[j]},
-                    {"label", high_school}
-                });
-                result["edges"].push_back({
-                    {"source", people[j]},
-                    {"target", people[i]},
-                    {"label", high_school}
-                });
-            }
-        }
+        pairs[pair_key(person1, person2)].add(labels.intern(getSafeText(stmt, 2)));
     }
 
     sqlite3_finalize(stmt);
     sqlite3_close(db);
 
-    std::cout << result.dump(2) << std::endl;
+    for (const auto &person : people.names) {
+        result["nodes"].push_back({{"id", person}});
+    }
+
+    append_labeled_edges(result, pairs, people, labels);
 
     return result;
 }
 
 
+json generate_edges_by_college(const std::string &db_path = "college_groups.db") {
+    return generate_edges_from_groups(db_path, "SELECT college, people FROM college_groups;");
+}
+
+
+json generate_edges_by_high_school(const std::string &db_path = "highschool_groups.db") {
+    return generate_edges_from_groups(db_path, "SELECT highschool, people FROM highschool_groups;");
+}
+
+
 json generate_edges_by_industry(const std::string &db_path = "industry_groups.db") {
-    json result;
-    result["nodes"] = json::array();
-    result["edges"] = json::array();
+    return generate_edges_from_groups(db_path, "SELECT industry, people FROM industry_groups;");
+}
 
-    sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return result;
+
+json generate_edges_by_current_company(const std::string &db_path = "company_groups.db") {
+    return generate_edges_from_groups(db_path, "SELECT company, people FROM company_groups;");
+}
+
+
+json generate_edges_by_previous_company(const std::string &db_path = "previous_companies.db") {
+    return generate_edges_from_groups(db_path, "SELECT company, people FROM previous_companies;");
+}
+
+
+json generate_edges_by_shared_skills(const std::string &db_path = "skill_edges.db") {
+    return generate_edges_from_pair_table(db_path, "SELECT person1, person2, shared_skills FROM shared_skills;");
+}
+
+
+json generate_edges_by_shared_interests(const std::string &db_path = "interests_edges.db") {
+    return generate_edges_from_pair_table(db_path, "SELECT person1, person2, shared_interests FROM interest_edges;");
+}
+
+
+json generate_edges_by_shared_goals(const std::string &db_path = "goals_edges.db") {
+    return generate_edges_from_pair_table(db_path, "SELECT person1, person2, shared_goal FROM share_goals;");
+}
+
+
+// layers that feed the composite view, named after the feature columns they come from
+enum Layer {
+    LAYER_COLLEGE,
+    LAYER_HIGH_SCHOOL,
+    LAYER_CURRENT_COMPANY,
+    LAYER_PREVIOUS_COMPANIES,
+    LAYER_INDUSTRY,
+    LAYER_SKILLS,
+    LAYER_INTERESTS,
+    LAYER_CAREER_GOALS,
+    LAYER_LOCATION,
+    LAYER_COUNT
+};
+
+const char* LAYER_NAMES[LAYER_COUNT] = {
+    "college", "high_school", "current_company", "previous_companies", "industry",
+    "skills", "interests", "career_goals", "location"
+};
+
+struct CompositeWeights {
+    // points added to a pair for every value they share in that layer
+    double weight[LAYER_COUNT] = {2.0, 1.5, 3.0, 2.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+    // pairs scoring below this are dropped
+    double threshold = 2.0;
+};
+
+
+std::vector<std::string> layer_values(const entry &e, int layer) {
+    switch (layer) {
+        case LAYER_COLLEGE:            return split_values(e.college);
+        case LAYER_HIGH_SCHOOL:        return split_values(e.highSchool);
+        case LAYER_CURRENT_COMPANY:    return split_values(e.currCompany);
+        case LAYER_PREVIOUS_COMPANIES: return split_values(e.prevCompanies);
+        case LAYER_INDUSTRY:           return split_values(e.industry);
+        case LAYER_SKILLS:             return split_values(e.skills);
+        case LAYER_INTERESTS:          return split_values(e.interests);
+        case LAYER_CAREER_GOALS:       return split_values(e.careerGoals);
+        case LAYER_LOCATION: {
+            // "Sunnyvale, CA" is one location, so don't split on the comma
+            std::string location = normalize_value(e.location);
+            if (location.empty()) return {};
+            return {location};
+        }
     }
+    return {};
+}
 
-    const char *query = "SELECT industry, people FROM industry_groups;";
-    sqlite3_stmt *stmt;
 
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return result;
+int layer_from_name(const std::string &name) {
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        if (name == LAYER_NAMES[layer]) return layer;
     }
+    return -1;
+}
 
-    std::set<std::string> unique_nodes;
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string industry = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string people_str = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+// parses "college=3,skills=0.5" on top of the defaults
+bool parse_composite_weights(const std::string &spec, CompositeWeights &weights) {
+    std::stringstream ss(spec);
+    std::string item;
 
-        std::vector<std::string> people = split_people(people_str);
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
 
-        // Add nodes
-        for (const auto &person : people) {
-            if (unique_nodes.insert(person).second) {
-                result["nodes"].push_back({{"id", person}});
-            }
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Bad weight (expected layer=value): " << item << std::endl;
+            return false;
         }
 
-        // Add edges for all combinations if more than one person
-        for (size_t i = 0; i < people.size(); ++i) {
-            for (size_t j = i + 1; j < people.size(); ++j) {
-                result["edges"].push_back({
-                    {"source", people[i]},
-                    {"target", people[j]},
-                    {"label", industry}
-                });
-                result["edges"].push_back({
-                    {"source", people[j]},
-                    {"target", people[i]},
-                    {"label", industry}
-                });
+        int layer = layer_from_name(item.substr(0, eq));
+        if (layer < 0) {
+            std::cerr << "Unknown layer in weights: " << item.substr(0, eq) << std::endl;
+            return false;
+        }
+
+        char *end = nullptr;
+        std::string number = item.substr(eq + 1);
+        double value = std::strtod(number.c_str(), &end);
+        if (number.empty() || *end != '\0') {
+            std::cerr << "Bad weight value: " << item << std::endl;
+            return false;
+        }
+        weights.weight[layer] = value;
+    }
+
+    return true;
+}
+
+
+struct CompositePair {
+    double weight = 0.0;
+    uint32_t layers = 0;  // bit per Layer
+    EdgeLabels shared;    // "layer: value" label ids
+};
+
+
+// Every pair of contacts sharing a value in a layer with non-zero weight, with the summed layer
+// weights and "layer: value" labels.
+PairMap<CompositePair> composite_pairs(const std::vector<entry>& entries, const CompositeWeights& weights, Interner& labels) {
+    // posting lists: value -> people holding it, one table per layer
+    std::vector<std::unordered_map<std::string, std::vector<uint32_t>>> postings(LAYER_COUNT);
+
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+            if (weights.weight[layer] == 0.0) continue;
+
+            for (const auto &value : layer_values(entries[i], layer)) {
+                auto &people = postings[layer][value];
+                // ids are added in increasing order, so a repeated value only needs a back() check
+                if (people.empty() || people.back() != i) {
+                    people.push_back(i);
+                }
             }
         }
     }
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    // single join pass: every pair inside a posting list picks up that layer's weight
+    PairMap<CompositePair> pairs(entries.size() * 4);
 
-    std::cout << result.dump(2) << std::endl;
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        double w = weights.weight[layer];
 
-    return result;
+        for (const auto &posting : postings[layer]) {
+            const auto &people = posting.second;
+            if (people.size() < 2) continue;
+
+            uint32_t labelId = labels.intern(std::string(LAYER_NAMES[layer]) + ": " + posting.first);
+
+            for (size_t i = 0; i < people.size(); ++i) {
+                for (size_t j = i + 1; j < people.size(); ++j) {
+                    CompositePair &pair = pairs[pair_key(people[i], people[j])];
+                    pair.weight += w;
+                    pair.layers |= 1u << layer;
+                    pair.shared.add(labelId);
+                }
+            }
+        }
+    }
+
+    return pairs;
 }
 
 
-json generate_edges_by_current_company(const std::string &db_path = "company_groups.db") {
+json generate_edges_by_composite(const std::vector<entry>& entries, const CompositeWeights& weights) {
     json result;
     result["nodes"] = json::array();
     result["edges"] = json::array();
 
-    sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return result;
-    }
-
-    const char *query = "SELECT company, people FROM company_groups;";
-    sqlite3_stmt *stmt;
-
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return result;
-    }
+    Interner labels;
+    PairMap<CompositePair> pairs = composite_pairs(entries, weights, labels);
 
     std::set<std::string> unique_nodes;
+    for (const auto &e : entries) {
+        if (unique_nodes.insert(e.name).second) {
+            result["nodes"].push_back({{"id", e.name}, {"name", e.name}, {"location", e.location}});
+        }
+    }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string company = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string people_str = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+    for (uint64_t key : pairs.sorted_keys()) {
+        const CompositePair &pair = *pairs.find(key);
+        if (pair.weight < weights.threshold) continue;
 
-        std::vector<std::string> people = split_people(people_str);
+        const entry &a = entries[pair_first(key)];
+        const entry &b = entries[pair_second(key)];
+        if (a.name == b.name) continue;
 
-        // Add nodes
-        for (const auto &person : people) {
-            if (unique_nodes.insert(person).second) {
-                result["nodes"].push_back({{"id", person}});
+        json layers = json::array();
+        for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+            if (pair.layers & (1u << layer)) {
+                layers.push_back(LAYER_NAMES[layer]);
             }
         }
 
-        // Add edges for all combinations if more than one person
-        for (size_t i = 0; i < people.size(); ++i) {
-            for (size_t j = i + 1; j < people.size(); ++j) {
-                result["edges"].push_back({
-                    {"source", people[i]},
-                    {"target", people[j]},
-                    {"label", company}
-                });
-                result["edges"].push_back({
-                    {"source", people[j]},
-                    {"target", people[i]},
-                    {"label", company}
-                });
-            }
+        json labelList = json::array();
+        std::string label;
+        for (uint32_t i = 0; i < pair.shared.size(); ++i) {
+            const std::string &text = labels.names[pair.shared.at(i)];
+            labelList.push_back(text);
+            label += (label.empty() ? "" : ", ") + text;
         }
-    }
-
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 
-    std::cout << result.dump(2) << std::endl;
+        result["edges"].push_back({
+            {"source", a.name},
+            {"target", b.name},
+            {"weight", pair.weight},
+            {"layers", layers},
+            {"labels", labelList},
+            {"label", label},
+            {"undirected", true}
+        });
+    }
 
     return result;
 }
 
 
-json generate_edges_by_previous_company(const std::string &db_path = "previous_companies.db") {
+// "similar/<name>": the k contacts closest to name in contacts.hnsw (built by
+// shared_text_engine --index), as a star around them labelled with the similarity.
+json generate_edges_by_similarity(const std::string &name, size_t k, const std::string &index_path = "contacts.hnsw") {
     json result;
     result["nodes"] = json::array();
     result["edges"] = json::array();
 
+    HnswIndex index;
+    if (!index.load(index_path)) {
+        std::cerr << "No " << index_path << " yet, run ./shared_text_engine --index" << std::endl;
+        return result;
+    }
+
     sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "cannot open database: " << sqlite3_errmsg(db) << std::endl;
+    if (sqlite3_open_v2("my_database.db", &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
         return result;
     }
 
-    const char *query = "SELECT company, people FROM previous_companies;";
+    std::map<int, std::string> names;
+    int self = -1;
     sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT id, name FROM contacts;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            int id = sqlite3_column_int(stmt, 0);
+            names[id] = getSafeText(stmt, 1);
+            if (self < 0 && names[id] == name) self = id;
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
 
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        std::cerr << "failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
+    const float *vector = self < 0 ? nullptr : index.vector_of(static_cast<uint32_t>(self));
+    if (!vector) {
+        std::cerr << "No indexed contact named " << name << std::endl;
         return result;
     }
 
-    std::set<std::string> unique_nodes;
+    result["nodes"].push_back({{"id", name}});
+    for (const auto &hit : index.search(vector, k + 1)) {
+        auto other = names.find(static_cast<int>(hit.first));
+        if (hit.first == static_cast<uint32_t>(self) || other == names.end()) continue;
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string previous_company = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string people_str = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        std::ostringstream label;
+        label.precision(2);
+        label << std::fixed << "similarity " << hit.second;
+        result["nodes"].push_back({{"id", other->second}});
+        result["edges"].push_back({
+            {"source", name},
+            {"target", other->second},
+            {"label", label.str()},
+            {"labels", {label.str()}},
+            {"weight", hit.second},
+            {"undirected", true}
+        });
+        if (result["edges"].size() == k) break;
+    }
+    return result;
+}
 
-        std::vector<std::string> people = split_people(people_str);
 
-        // Add nodes
-        for (const auto &person : people) {
-            if (unique_nodes.insert(person).second) {
-                result["nodes"].push_back({{"id", person}});
+// --weights, --layers and --threshold on top of the composite defaults; false for a bad spec.
+// --layers=college,skills keeps only those layers, and unless --threshold says otherwise one
+// shared value in any of them is enough for an edge.
+bool composite_options(const std::map<std::string, std::string> &options, CompositeWeights &weights) {
+    auto it = options.find("weights");
+    if (it != options.end() && !parse_composite_weights(it->second, weights)) {
+        return false;
+    }
+    it = options.find("layers");
+    if (it != options.end() && !it->second.empty()) {
+        bool keep[LAYER_COUNT] = {};
+        std::stringstream ss(it->second);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            int layer = layer_from_name(name);
+            if (layer < 0) {
+                std::cerr << "Unknown layer: " << name << std::endl;
+                return false;
             }
+            keep[layer] = true;
         }
 
-        // Add edges for all combinations if more than one person
-        for (size_t i = 0; i < people.size(); ++i) {
-            for (size_t j = i + 1; j < people.size(); ++j) {
-                result["edges"].push_back({
-                    {"source", people[i]},
-                    {"target", people[j]},
-                    {"label", previous_company}
-                });
-                result["edges"].push_back({
-                    {"source", people[j]},
-                    {"target", people[i]},
-                    {"label", previous_company}
-                });
+        double smallest = 0.0;
+        for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+            if (!keep[layer]) weights.weight[layer] = 0.0;
+            else if (weights.weight[layer] > 0.0 && (smallest == 0.0 || weights.weight[layer] < smallest)) smallest = weights.weight[layer];
+        }
+        weights.threshold = smallest;
+    }
+    return number_option(options, "threshold", weights.threshold, weights.threshold);
+}
+
+
+// The composite graph over entry indices: one edge per pair scoring at least the threshold,
+// weighted by the score. Labels are only worked out for the edges a view actually prints.
+struct ContactGraph {
+    const std::vector<entry> *entries;
+    std::vector<GraphEdge> edges;
+    std::vector<uint32_t> layers;   // per edge, bit per Layer the two people share
+
+    // what edge e's two people share, e.g. "college: mit, skills: c++"
+    std::string edge_label(uint32_t e) const {
+        std::string label;
+        for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+            if (!(layers[e] & (1u << layer))) continue;
+            std::vector<std::string> other = layer_values((*entries)[edges[e].b], layer);
+            for (const auto &value : layer_values((*entries)[edges[e].a], layer)) {
+                if (std::find(other.begin(), other.end(), value) == other.end()) continue;
+                label += (label.empty() ? "" : ", ") + std::string(LAYER_NAMES[layer]) + ": " + value;
             }
         }
+        return label;
     }
+};
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 
-    std::cout << result.dump(2) << std::endl;
+// Group membership of every layer with non-zero weight: one posting list per layer value.
+struct LayerPostings {
+    std::vector<std::vector<uint32_t>> postings;   // people holding one layer value, ascending
+    std::vector<int> layer;                        // per posting
+    std::vector<std::string> value;                // per posting
+    std::vector<std::vector<uint32_t>> held;       // postings each person is on
+};
+
 
-    return result;
+LayerPostings layer_postings(const std::vector<entry> &entries, const CompositeWeights &weights) {
+    LayerPostings lp;
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    lp.held.resize(n);
+
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        if (weights.weight[layer] == 0.0) continue;
+
+        std::unordered_map<std::string, uint32_t> ids;
+        for (uint32_t i = 0; i < n; ++i) {
+            for (const auto &value : layer_values(entries[i], layer)) {
+                auto it = ids.emplace(value, static_cast<uint32_t>(lp.postings.size())).first;
+                if (it->second == lp.postings.size()) {
+                    lp.postings.emplace_back();
+                    lp.layer.push_back(layer);
+                    lp.value.push_back(value);
+                }
+                auto &people = lp.postings[it->second];
+                if (people.empty() || people.back() != i) {
+                    people.push_back(i);
+                    lp.held[i].push_back(it->second);
+                }
+            }
+        }
+    }
+    return lp;
 }
 
 
-json generate_edges_by_shared_skills(const std::string &db_path = "skill_edges.db") {
-    json result;
-    result["nodes"] = json::array();
-    result["edges"] = json::array();
+// Same scores as composite_pairs, but accumulated a row at a time: each person walks the
+// posting lists they are on into a dense score array over the people after them. No pair hash
+// map is built, and rows are independent, so they are spread over the shared pool.
+ContactGraph build_contact_graph(const std::vector<entry> &entries, const CompositeWeights &weights) {
+    ContactGraph g;
+    g.entries = &entries;
+    uint32_t n = static_cast<uint32_t>(entries.size());
+
+    LayerPostings lp = layer_postings(entries, weights);
+    const auto &postings = lp.postings;
+    const auto &postingLayer = lp.layer;
+    const auto &held = lp.held;
+
+    std::vector<std::vector<GraphEdge>> rowEdges(n);
+    std::vector<std::vector<uint32_t>> rowLayers(n);
+    parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+        std::vector<double> score(n, 0.0);
+        std::vector<uint32_t> bits(n, 0);
+        std::vector<uint32_t> touched;
+
+        for (uint32_t i = static_cast<uint32_t>(begin); i < end; ++i) {
+            for (uint32_t p : held[i]) {
+                const auto &people = postings[p];
+                double w = weights.weight[postingLayer[p]];
+                for (auto it = std::upper_bound(people.begin(), people.end(), i); it != people.end(); ++it) {
+                    if (bits[*it] == 0) touched.push_back(*it);
+                    score[*it] += w;
+                    bits[*it] |= 1u << postingLayer[p];
+                }
+            }
 
-    sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return result;
+            std::sort(touched.begin(), touched.end());
+            for (uint32_t j : touched) {
+                if (score[j] >= weights.threshold && entries[i].name != entries[j].name) {
+                    rowEdges[i].push_back({i, j, static_cast<float>(score[j])});
+                    rowLayers[i].push_back(bits[j]);
+                }
+                score[j] = 0.0;
+                bits[j] = 0;
+            }
+            touched.clear();
+        }
+    }, 16);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        g.edges.insert(g.edges.end(), rowEdges[i].begin(), rowEdges[i].end());
+        g.layers.insert(g.layers.end(), rowLayers[i].begin(), rowLayers[i].end());
     }
+    return g;
+}
 
-    const char *query = "SELECT person1, person2, shared_skills FROM shared_skills;";
-    sqlite3_stmt *stmt;
 
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+const char *GRAPH_CACHE_FILE = "graph_cache.db";
+
+// Identifies one composite graph: a hash of every field the layers read, then the weights,
+// as "<content>/<weights>". Any edit to a contact changes the first half.
+std::string graph_version(const std::vector<entry> &entries, const CompositeWeights &weights) {
+    uint64_t content = 0;
+    for (const auto &e : entries) {
+        for (const std::string *field : {&e.name, &e.location, &e.currCompany, &e.prevCompanies, &e.industry, &e.skills,
+                                         &e.interests, &e.careerGoals, &e.college, &e.highSchool}) {
+            content = mix64(content ^ hash_term(*field));
+        }
+    }
+    std::ostringstream config;
+    for (double w : weights.weight) config << w << ",";
+    config << weights.threshold;
+
+    char version[40];
+    std::snprintf(version, sizeof(version), "%016llx/%016llx", static_cast<unsigned long long>(content),
+                  static_cast<unsigned long long>(hash_term(config.str())));
+    return version;
+}
+
+
+const char *GRAPH_CACHE_SCHEMA = R"(
+    CREATE TABLE IF NOT EXISTS centrality (
+        graph_version TEXT NOT NULL,
+        contact INTEGER NOT NULL,
+        pagerank REAL,
+        eigenvector REAL,
+        PRIMARY KEY (graph_version, contact)
+    );
+    CREATE TABLE IF NOT EXISTS contact_graphs (
+        graph_version TEXT PRIMARY KEY,
+        nodes INTEGER NOT NULL,
+        edges BLOB NOT NULL,
+        layers BLOB NOT NULL
+    );)";
+
+
+// graph_cache.db with its tables, or nullptr (and a message) when it can't be opened
+sqlite3 *open_graph_cache() {
+    sqlite3 *db = nullptr;
+    if (sqlite3_open(GRAPH_CACHE_FILE, &db) != SQLITE_OK) {
+        std::cerr << "Cannot open " << GRAPH_CACHE_FILE << ": " << sqlite3_errmsg(db) << std::endl;
         sqlite3_close(db);
-        return result;
+        return nullptr;
     }
+    sqlite3_busy_timeout(db, 5000);
+    char *errorMessage = nullptr;
+    if (sqlite3_exec(db, GRAPH_CACHE_SCHEMA, nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+        std::cerr << "SQL error: " << errorMessage << std::endl;
+        sqlite3_free(errorMessage);
+        sqlite3_close(db);
+        return nullptr;
+    }
+    return db;
+}
 
-    std::set<std::string> unique_nodes;
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string person1 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string person2 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-        std::string skills = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+// Deletes table's rows for contents other than version's, and for version itself, ahead of
+// writing it again. Other weights over the same contacts are kept.
+bool drop_stale_versions(sqlite3 *db, const char *table, const std::string &version) {
+    std::string content = version.substr(0, version.find('/'));
+    std::string sql = std::string("DELETE FROM ") + table + " WHERE substr(graph_version, 1, ?) != ? OR graph_version = ?;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+    sqlite3_bind_int(stmt, 1, static_cast<int>(content.size()));
+    sqlite3_bind_text(stmt, 2, content.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, version.c_str(), -1, SQLITE_TRANSIENT);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
 
-        if (unique_nodes.insert(person1).second) {
-            result["nodes"].push_back({{"id", person1}});
+
+// build_contact_graph through graph_cache.db. Each graph_version's edge list and layer bits are
+// stored once as two blobs, by ./generate_edges --refresh for the default weights or by the
+// first view asking for others, so later views read them back instead of rescoring every pair.
+ContactGraph cached_contact_graph(const std::vector<entry> &entries, const CompositeWeights &weights) {
+    ContactGraph g;
+    g.entries = &entries;
+    std::string version = graph_version(entries, weights);
+
+    sqlite3 *db = open_graph_cache();
+    sqlite3_stmt *stmt;
+    bool hit = false;
+    if (db && sqlite3_prepare_v2(db, "SELECT nodes, edges, layers FROM contact_graphs WHERE graph_version = ?;",
+                                 -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, version.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int64(stmt, 0) == static_cast<sqlite3_int64>(entries.size())) {
+            size_t edgeBytes = static_cast<size_t>(sqlite3_column_bytes(stmt, 1));
+            size_t layerBytes = static_cast<size_t>(sqlite3_column_bytes(stmt, 2));
+            size_t count = edgeBytes / sizeof(GraphEdge);
+            if (edgeBytes % sizeof(GraphEdge) == 0 && layerBytes == count * sizeof(uint32_t)) {
+                g.edges.resize(count);
+                g.layers.resize(count);
+                if (count > 0) {
+                    std::memcpy(g.edges.data(), sqlite3_column_blob(stmt, 1), edgeBytes);
+                    std::memcpy(g.layers.data(), sqlite3_column_blob(stmt, 2), layerBytes);
+                }
+                hit = true;
+            }
         }
-        if (unique_nodes.insert(person2).second) {
-            result["nodes"].push_back({{"id", person2}});
+        sqlite3_finalize(stmt);
+    }
+    if (hit) {
+        sqlite3_close(db);
+        return g;
+    }
+
+    g = build_contact_graph(entries, weights);
+    if (db && sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+        bool ok = drop_stale_versions(db, "contact_graphs", version);
+        if (ok && sqlite3_prepare_v2(db, "INSERT INTO contact_graphs (graph_version, nodes, edges, layers) VALUES (?, ?, ?, ?);",
+                                     -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, version.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(entries.size()));
+            sqlite3_bind_blob64(stmt, 3, g.edges.data(), g.edges.size() * sizeof(GraphEdge), SQLITE_STATIC);
+            sqlite3_bind_blob64(stmt, 4, g.layers.data(), g.layers.size() * sizeof(uint32_t), SQLITE_STATIC);
+            ok = sqlite3_step(stmt) == SQLITE_DONE;
+            sqlite3_finalize(stmt);
+        } else {
+            ok = false;
+        }
+        sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+        if (!ok) std::cerr << "Could not cache the contact graph: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_close(db);
+    return g;
+}
+
+
+// first entry with this name, or -1
+int find_entry(const std::vector<entry> &entries, const std::string &name) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+
+// a 1-10 rating as 0..1, 0 when missing
+double rating(const std::string &value) {
+    double r = std::strtod(value.c_str(), nullptr);
+    return std::min(std::max(r, 0.0), 10.0) / 10.0;
+}
+
+
+const char *ROOT_NAME = "Sohil Doshi";  // "me", the root the layered views hang everyone off
+
+// "path/<name>": the k best introduction chains from me (or --from=<name>) to name.
+//
+// The graph is the composite graph plus me, linked to every contact. With --mode=hops paths
+// are counted in introductions and I only start from contacts at --min-closeness (default 7)
+// or closer, otherwise every answer would be the one hop to name. The default weighted mode
+// prices each hop instead:
+//   me -> contact     1 + 4 * (1 - (closeness + reliability) / 2)
+//   contact - contact 1 + 2 / composite score + (1 - average reliability of the two)
+// so a chain through people I'm close to, who reliably follow up and share a lot with the
+// next person, beats a direct cold contact.
+bool generate_edges_by_path(const std::string &to, const std::vector<entry> &entries,
+                            const std::map<std::string, std::string> &options, const CompositeWeights &weights,
+                            json &result) {
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
+    result["paths"] = json::array();
+
+    OptionReader option(options);
+    bool weighted = option.choice("mode", {"weighted", "hops"}) == "weighted";
+    size_t k = option.count("k", 3, 1);
+    double minCloseness = option.number("min-closeness", 7, 0, 10) / 10.0;
+    std::string from = option.text("from", ROOT_NAME);
+    if (!option.ok()) return false;
+
+    int target = find_entry(entries, to);
+    uint32_t root = static_cast<uint32_t>(entries.size());
+    int source = from == ROOT_NAME ? static_cast<int>(root) : find_entry(entries, from);
+    if (target < 0 || source < 0) {
+        std::cerr << "No contact named " << (target < 0 ? to : from) << std::endl;
+        return false;
+    }
+
+    std::vector<double> reliable(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) reliable[i] = rating(entries[i].reliability);
+
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    std::vector<GraphEdge> edges = contacts.edges;
+    for (GraphEdge &e : edges) {
+        double reliability = (reliable[e.a] + reliable[e.b]) / 2.0;
+        e.weight = static_cast<float>(1.0 + 2.0 / std::max(e.weight, 0.5f) + (1.0 - reliability));
+    }
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        double closeness = rating(entries[i].closeness);
+        if (!weighted && closeness < minCloseness) continue;
+        edges.push_back({root, i, static_cast<float>(1.0 + 4.0 * (1.0 - (closeness + reliable[i]) / 2.0))});
+    }
+
+    CsrGraph graph = build_csr(root + 1, edges);
+    auto name_of = [&](uint32_t u) { return u == root ? std::string(ROOT_NAME) : entries[u].name; };
+    auto label_of = [&](uint32_t id) {
+        if (id < contacts.edges.size()) return contacts.edge_label(id);
+        const entry &e = entries[edges[id].b];
+        return "closeness " + (e.closeness.empty() ? std::string("?") : e.closeness) +
+               ", reliability " + (e.reliability.empty() ? std::string("?") : e.reliability);
+    };
+
+    std::set<uint32_t> nodes, used;
+    for (const GraphPath &path : k_best_paths(graph, static_cast<uint32_t>(source), static_cast<uint32_t>(target), k, weighted)) {
+        json steps = json::array();
+        for (size_t i = 0; i < path.edges.size(); ++i) {
+            steps.push_back({{"from", name_of(path.nodes[i])}, {"to", name_of(path.nodes[i + 1])},
+                             {"via", label_of(path.edges[i])}});
+            used.insert(path.edges[i]);
         }
+        nodes.insert(path.nodes.begin(), path.nodes.end());
+        result["paths"].push_back({{"cost", path.cost}, {"hops", path.edges.size()}, {"steps", steps}});
+    }
 
+    for (uint32_t u : nodes) {
+        result["nodes"].push_back({{"id", name_of(u)}, {"name", name_of(u)}});
+    }
+    for (uint32_t id : used) {
+        const GraphEdge &e = edges[id];
         result["edges"].push_back({
-            {"source", person1},
-            {"target", person2},
-            {"label", skills}
+            {"source", name_of(e.a)},
+            {"target", name_of(e.b)},
+            {"label", label_of(id)},
+            {"labels", {label_of(id)}},
+            {"weight", e.weight},
+            {"undirected", true}
         });
-        result["edges"].push_back({
-            {"source", person2},
-            {"target", person1},
-            {"label", skills}
+    }
+    return true;
+}
+
+
+// "ego/<name>": everyone within --hops (default 2) of name over the composite graph, or just
+// --layers, capped at --max-nodes (default 150) so the payload stays small however big the
+// network is. Nodes carry their hop count and "more" when they have neighbours left out, which
+// the page uses for click-to-expand.
+bool generate_edges_by_ego(const std::string &name, const std::vector<entry> &entries,
+                           const std::map<std::string, std::string> &options, const CompositeWeights &weights,
+                           json &result) {
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
+
+    OptionReader option(options);
+    uint32_t hops = static_cast<uint32_t>(option.count("hops", 2));
+    size_t maxNodes = option.count("max-nodes", 150, 1);
+    if (!option.ok()) return false;
+
+    int center = find_entry(entries, name);
+    if (center < 0) {
+        std::cerr << "No contact named " << name << std::endl;
+        return false;
+    }
+
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    CsrGraph graph = build_csr(static_cast<uint32_t>(entries.size()), contacts.edges);
+    EgoNetwork ego = ego_network(graph, static_cast<uint32_t>(center), hops, maxNodes);
+
+    std::vector<char> inside(entries.size(), 0);
+    for (uint32_t u : ego.nodes) inside[u] = 1;
+
+    for (size_t i = 0; i < ego.nodes.size(); ++i) {
+        uint32_t u = ego.nodes[i];
+        uint32_t kept = 0;
+        for (uint64_t arc = graph.offsets[u]; arc < graph.offsets[u + 1]; ++arc) {
+            uint32_t v = graph.targets[arc];
+            if (!inside[v]) continue;
+            ++kept;
+            if (u < v) {
+                std::string label = contacts.edge_label(graph.edges[arc]);
+                result["edges"].push_back({
+                    {"source", entries[u].name},
+                    {"target", entries[v].name},
+                    {"label", label},
+                    {"labels", {label}},
+                    {"weight", graph.weights[arc]},
+                    {"undirected", true}
+                });
+            }
+        }
+        result["nodes"].push_back({
+            {"id", entries[u].name},
+            {"name", entries[u].name},
+            {"location", entries[u].location},
+            {"hops", ego.hops[i]},
+            {"more", kept < graph.degree(u)}
         });
     }
+    result["truncated"] = ego.truncated;
+    return true;
+}
+
+
+// Unites the members of every posting list in `layer` (-1 for all of them) straight from group
+// membership: each member is joined to the group's first member, so a group of k people costs
+// k - 1 unions instead of the k^2 / 2 edges of its clique. Groups are spread over the pool.
+void unite_groups(ConcurrentUnionFind &uf, const LayerPostings &lp, int layer) {
+    parallel_for(shared_pool(), 0, lp.postings.size(), [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            if (layer >= 0 && lp.layer[p] != layer) continue;
+            const auto &people = lp.postings[p];
+            for (size_t i = 1; i < people.size(); ++i) uf.unite(people[0], people[i]);
+        }
+    }, 256);
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 
-    std::cout << result.dump(2) << std::endl;
+// "components": connected islands of the network, for every layer on its own and for all of
+// them together (sharing any value in any --layers links two people). Nodes carry their
+// composite component id and their id in each layer; "components" lists the composite ones
+// largest first, so a client can lay out or shard one island at a time.
+json generate_edges_by_components(const std::vector<entry> &entries, const CompositeWeights &weights) {
+    json result;
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
 
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    LayerPostings lp = layer_postings(entries, weights);
+
+    ConcurrentUnionFind all(n);
+    unite_groups(all, lp, -1);
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> component = all.components(sizes);
+
+    std::vector<int> layers;
+    std::vector<std::vector<uint32_t>> layerComponent;
+    result["layers"] = json::object();
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        if (weights.weight[layer] == 0.0) continue;
+
+        ConcurrentUnionFind uf(n);
+        unite_groups(uf, lp, layer);
+        std::vector<uint32_t> layerSizes;
+        layers.push_back(layer);
+        layerComponent.push_back(uf.components(layerSizes));
+
+        std::sort(layerSizes.rbegin(), layerSizes.rend());
+        uint32_t isolated = static_cast<uint32_t>(std::count(layerSizes.begin(), layerSizes.end(), 1u));
+        layerSizes.resize(layerSizes.size() - isolated);
+        result["layers"][LAYER_NAMES[layer]] = {
+            {"components", layerSizes.size() + isolated},
+            {"isolated", isolated},
+            {"sizes", layerSizes}
+        };
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        json byLayer = json::object();
+        for (size_t l = 0; l < layers.size(); ++l) byLayer[LAYER_NAMES[layers[l]]] = layerComponent[l][i];
+        result["nodes"].push_back({
+            {"id", entries[i].name},
+            {"name", entries[i].name},
+            {"location", entries[i].location},
+            {"component", component[i]},
+            {"layer_components", byLayer}
+        });
+    }
+
+    std::vector<uint32_t> order(sizes.size());
+    for (uint32_t c = 0; c < order.size(); ++c) order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return sizes[x] > sizes[y]; });
+    result["components"] = json::array();
+    for (uint32_t c : order) result["components"].push_back({{"id", c}, {"size", sizes[c]}});
     return result;
 }
 
 
-json generate_edges_by_shared_interests(const std::string &db_path = "interests_edges.db") {
-    json result;
+// "communities": circles found by Louvain on the composite graph (--resolution, default 1,
+// above 1 gives more and smaller circles). Nodes carry their community; "communities" names
+// each one after the value most of its members share; "summary" is the community-level graph,
+// one node per community and edges weighted by the summed scores between them. With --summary
+// the summary graph is what gets drawn, a cheap overview of a network of any size.
+bool generate_edges_by_communities(const std::vector<entry> &entries, const std::map<std::string, std::string> &options,
+                                   const CompositeWeights &weights, json &result) {
     result["nodes"] = json::array();
     result["edges"] = json::array();
 
-    sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return result;
+    OptionReader option(options);
+    double resolution = option.number("resolution", 1.0, 0);
+    bool summaryOnly = option.has("summary");
+    if (!option.ok()) return false;
+
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    CsrGraph graph = build_csr(n, contacts.edges);
+    Communities found = louvain(graph, resolution);
+    uint32_t count = static_cast<uint32_t>(found.sizes.size());
+
+    // the most common "layer: value" among each community's members names it
+    LayerPostings lp = layer_postings(entries, weights);
+    std::vector<std::unordered_map<uint32_t, uint32_t>> held(count);
+    for (uint32_t p = 0; p < lp.postings.size(); ++p) {
+        for (uint32_t person : lp.postings[p]) ++held[found.of[person]][p];
+    }
+    std::vector<std::string> names(count);
+    json communities = json::array();
+    for (uint32_t c = 0; c < count; ++c) {
+        uint32_t best = UINT32_MAX, bestCount = 0;
+        for (const auto &h : held[c]) {
+            if (h.second > bestCount || (h.second == bestCount && h.first < best)) {
+                best = h.first;
+                bestCount = h.second;
+            }
+        }
+        names[c] = "circle " + std::to_string(c);
+        std::string label;
+        if (best != UINT32_MAX && found.sizes[c] > 1) {
+            label = std::string(LAYER_NAMES[lp.layer[best]]) + ": " + lp.value[best];
+        }
+        communities.push_back({{"id", c}, {"size", found.sizes[c]}, {"label", label}, {"share", bestCount}});
     }
 
-    const char *query = "SELECT person1, person2, shared_interests FROM interest_edges;";
-    sqlite3_stmt *stmt;
+    // community-level graph
+    std::vector<std::unordered_map<uint32_t, double>> between(count);
+    std::vector<double> inside(count, 0.0);
+    for (const GraphEdge &e : contacts.edges) {
+        uint32_t a = found.of[e.a], b = found.of[e.b];
+        if (a == b) inside[a] += e.weight;
+        else between[std::min(a, b)][std::max(a, b)] += e.weight;
+    }
+    json summary = {{"nodes", json::array()}, {"edges", json::array()}};
+    for (uint32_t c = 0; c < count; ++c) {
+        summary["nodes"].push_back({{"id", names[c]}, {"name", names[c]}, {"size", found.sizes[c]},
+                                    {"label", communities[c]["label"]}, {"internal_weight", inside[c]}});
+        std::vector<std::pair<uint32_t, double>> row(between[c].begin(), between[c].end());
+        std::sort(row.begin(), row.end());
+        for (const auto &link : row) {
+            std::ostringstream label;
+            label << "weight " << link.second;
+            summary["edges"].push_back({{"source", names[c]}, {"target", names[link.first]}, {"weight", link.second},
+                                        {"label", label.str()}, {"undirected", true}});
+        }
+    }
 
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return result;
+    result["modularity"] = found.modularity;
+    result["levels"] = found.levels;
+    result["communities"] = communities;
+    if (summaryOnly) {
+        result["nodes"] = summary["nodes"];
+        result["edges"] = summary["edges"];
+        return true;
     }
 
-    std::set<std::string> unique_nodes;
+    for (uint32_t i = 0; i < n; ++i) {
+        result["nodes"].push_back({
+            {"id", entries[i].name},
+            {"name", entries[i].name},
+            {"location", entries[i].location},
+            {"community", found.of[i]}
+        });
+    }
+    result["summary"] = summary;
+    return true;
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string person1 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string person2 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-        std::string interests = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
 
-        if (unique_nodes.insert(person1).second) {
-            result["nodes"].push_back({{"id", person1}});
+// weights for one layer's own graph: two people are linked when they share any value in it
+CompositeWeights single_layer(int layer) {
+    CompositeWeights only;
+    for (double &w : only.weight) w = 0.0;
+    only.weight[layer] = 1.0;
+    only.threshold = 1.0;
+    return only;
+}
+
+
+// "triangles": how tightly knit everyone's circles are. For every layer with non-zero weight
+// (all of them, or --layers), and for the composite graph, each contact gets the number of
+// triangles they close and their local clustering coefficient; "layers" has each graph's
+// triangle total, transitivity and average clustering. A layer's graph links two people who
+// share any value in it.
+json generate_edges_by_triangles(const std::vector<entry> &entries, const CompositeWeights &weights) {
+    json result;
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
+    result["layers"] = json::object();
+
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    std::vector<std::string> names;
+    std::vector<Triangles> found;
+    auto count = [&](const std::string &name, const CompositeWeights &w) {
+        ContactGraph contacts = build_contact_graph(entries, w);
+        names.push_back(name);
+        found.push_back(count_triangles(build_csr(n, contacts.edges)));
+        const Triangles &t = found.back();
+        result["layers"][name] = {
+            {"triangles", t.total},
+            {"transitivity", t.transitivity},
+            {"average_clustering", t.average_clustering}
+        };
+    };
+
+    count("composite", weights);
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        if (weights.weight[layer] == 0.0) continue;
+        count(LAYER_NAMES[layer], single_layer(layer));
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        json triangles = json::object(), clustering = json::object();
+        for (size_t l = 0; l < names.size(); ++l) {
+            triangles[names[l]] = found[l].count[i];
+            clustering[names[l]] = found[l].clustering[i];
         }
-        if (unique_nodes.insert(person2).second) {
-            result["nodes"].push_back({{"id", person2}});
+        result["nodes"].push_back({
+            {"id", entries[i].name},
+            {"name", entries[i].name},
+            {"location", entries[i].location},
+            {"triangles", triangles},
+            {"clustering", clustering}
+        });
+    }
+    return result;
+}
+
+
+// "meet" or "meet/<name>": people I (or name) should get to know, by personalized PageRank over
+// the composite graph (or --layers). For name the walk restarts at name, and people sharing a
+// direct link with them are skipped as already known. For me it restarts at my strong ties,
+// contacts at --strong (default 7) closeness or more, weighted by closeness, and only my weaker
+// contacts are suggested: the ones my inner circle's neighbourhood keeps leading back to.
+// Each of the --k (default 10) suggestions comes with who they are best reached through ("via").
+// --alpha (default 0.15) is the restart chance and --epsilon (default 1e-7) the push accuracy
+// per average-weight edge; the mass left unpushed is reported as "residual".
+bool generate_edges_by_meet(const std::string &from, const std::vector<entry> &entries,
+                            const std::map<std::string, std::string> &options, const CompositeWeights &weights,
+                            json &result) {
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
+    result["suggestions"] = json::array();
+
+    OptionReader option(options);
+    size_t k = option.count("k", 10, 1);
+    double alpha = option.number("alpha", 0.15, 0, 1), epsilon = option.number("epsilon", 1e-7, 0);
+    double strong = option.number("strong", 7, 0, 10) / 10.0;
+    if (!option.ok()) return false;
+    if (alpha == 0.0 || alpha == 1.0 || epsilon == 0.0) {
+        std::cerr << "--alpha must be between 0 and 1 and --epsilon positive" << std::endl;
+        return false;
+    }
+
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    bool fromRoot = from.empty() || from == ROOT_NAME;
+    int source = fromRoot ? -1 : find_entry(entries, from);
+    if (!fromRoot && source < 0) {
+        std::cerr << "No contact named " << from << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<uint32_t, double>> seeds;
+    if (fromRoot) {
+        for (uint32_t i = 0; i < n; ++i) {
+            double closeness = rating(entries[i].closeness);
+            if (closeness >= strong) seeds.emplace_back(i, closeness);
         }
+        if (seeds.empty()) {
+            // nobody to start from is an empty answer, not a bad request
+            std::cerr << "No contacts at closeness " << strong * 10 << " or more to start from" << std::endl;
+            return true;
+        }
+    } else {
+        seeds.emplace_back(static_cast<uint32_t>(source), 1.0);
+    }
 
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    CsrGraph graph = build_csr(n, contacts.edges);
+    double meanWeight = 0.0;
+    for (const GraphEdge &e : contacts.edges) meanWeight += e.weight;
+    meanWeight = contacts.edges.empty() ? 1.0 : meanWeight / contacts.edges.size();
+    PersonalizedRank ranked = personalized_pagerank(graph, seeds, alpha, epsilon / meanWeight);
+
+    std::vector<double> score(n, 0.0);
+    for (const auto &s : ranked.scores) score[s.first] = s.second;
+    std::vector<double> strength(n, 0.0);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint64_t arc = graph.offsets[u]; arc < graph.offsets[u + 1]; ++arc) strength[u] += graph.weights[arc];
+    }
 
-        result["edges"].push_back({
-            {"source", person1},
-            {"target", person2},
-            {"label", interests}
+    auto linked = [&](uint32_t u, uint32_t v) {
+        auto begin = graph.targets.begin() + graph.offsets[u], end = graph.targets.begin() + graph.offsets[u + 1];
+        auto it = std::lower_bound(begin, end, v);
+        return it != end && *it == v ? static_cast<int64_t>(graph.edges[it - graph.targets.begin()]) : int64_t(-1);
+    };
+    auto known = [&](uint32_t v) {
+        if (fromRoot) return rating(entries[v].closeness) >= strong;
+        return static_cast<int>(v) == source || linked(static_cast<uint32_t>(source), v) >= 0;
+    };
+
+    std::set<uint32_t> shown, suggested, used;
+    if (!fromRoot) shown.insert(static_cast<uint32_t>(source));
+    for (const auto &s : ranked.scores) {
+        if (suggested.size() == k) break;
+        uint32_t v = s.first;
+        if (known(v)) continue;
+
+        // the neighbour that passed v the most: its score over its strength is what it hands on
+        // per unit of edge weight
+        int64_t via = -1;
+        double best = 0.0;
+        for (uint64_t arc = graph.offsets[v]; arc < graph.offsets[v + 1]; ++arc) {
+            uint32_t u = graph.targets[arc];
+            double passed = score[u] * graph.weights[arc] / strength[u];
+            if (passed > best) {
+                best = passed;
+                via = u;
+            }
+        }
+
+        suggested.insert(v);
+        shown.insert(v);
+        json suggestion = {{"name", entries[v].name}, {"score", s.second}};
+        if (via >= 0) {
+            shown.insert(static_cast<uint32_t>(via));
+            used.insert(static_cast<uint32_t>(linked(v, static_cast<uint32_t>(via))));
+            if (!fromRoot) {
+                int64_t first = linked(static_cast<uint32_t>(source), static_cast<uint32_t>(via));
+                if (first >= 0) used.insert(static_cast<uint32_t>(first));
+            }
+            suggestion["via"] = entries[via].name;
+        }
+        result["suggestions"].push_back(suggestion);
+    }
+
+    if (fromRoot) {
+        result["nodes"].push_back({{"id", ROOT_NAME}, {"name", ROOT_NAME}});
+    }
+    for (uint32_t u : shown) {
+        result["nodes"].push_back({
+            {"id", entries[u].name},
+            {"name", entries[u].name},
+            {"location", entries[u].location},
+            {"score", score[u]},
+            {"suggested", suggested.count(u) > 0}
         });
+        // from me, the people I'd ask hang off me by how close we are
+        if (fromRoot && !suggested.count(u)) {
+            result["edges"].push_back({
+                {"source", ROOT_NAME},
+                {"target", entries[u].name},
+                {"label", "closeness " + entries[u].closeness},
+                {"undirected", true}
+            });
+        }
+    }
+    for (uint32_t id : used) {
+        const GraphEdge &e = contacts.edges[id];
         result["edges"].push_back({
-            {"source", person2},
-            {"target", person1},
-            {"label", interests}
+            {"source", entries[e.a].name},
+            {"target", entries[e.b].name},
+            {"label", contacts.edge_label(id)},
+            {"weight", e.weight},
+            {"undirected", true}
         });
     }
+    result["residual"] = ranked.residual;
+    result["pushes"] = ranked.pushes;
+    return true;
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+// "links": likely but missing relationships, scored by the neighbours two people share on the
+// composite graph (or --layers). --score picks common neighbours ("cn"), Adamic-Adar ("aa",
+// the default) or resource allocation ("ra"). By default every contact, or only --for=<name>,
+// gets its --k (default 5) best unlinked partners; --pairs="A|B;C|D" scores just those pairs
+// instead, linked or not, under "pairs".
+bool generate_edges_by_links(const std::vector<entry> &entries, const std::map<std::string, std::string> &options,
+                             const CompositeWeights &weights, json &result) {
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
 
-    std::cout << result.dump(2) << std::endl;
+    OptionReader option(options);
+    std::string scoreName = option.choice("score", {"aa", "cn", "ra"});
+    size_t k = option.count("k", 5, 1);
+    if (!option.ok()) return false;
+    LinkScore kind = scoreName == "cn" ? LinkScore::COMMON_NEIGHBOURS
+                   : scoreName == "ra" ? LinkScore::RESOURCE_ALLOCATION : LinkScore::ADAMIC_ADAR;
+
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    CsrGraph graph = build_csr(n, contacts.edges);
+
+    std::set<uint32_t> shown;
+    auto add_edge = [&](const LinkPrediction &p) {
+        shown.insert(p.a);
+        shown.insert(p.b);
+        result["edges"].push_back({
+            {"source", entries[p.a].name},
+            {"target", entries[p.b].name},
+            {"score", p.score},
+            {"common", p.common},
+            {"label", std::to_string(p.common) + " in common"},
+            {"predicted", true},
+            {"undirected", true}
+        });
+    };
+
+    if (options.count("pairs")) {
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        std::stringstream list(options.at("pairs"));
+        std::string item;
+        while (std::getline(list, item, ';')) {
+            size_t bar = item.find('|');
+            int a = bar == std::string::npos ? -1 : find_entry(entries, item.substr(0, bar));
+            int b = bar == std::string::npos ? -1 : find_entry(entries, item.substr(bar + 1));
+            if (a < 0 || b < 0) {
+                std::cerr << "Bad pair \"" << item << "\": expected two contact names as A|B" << std::endl;
+                return false;
+            }
+            pairs.emplace_back(a, b);
+        }
 
-    return result;
+        result["pairs"] = json::array();
+        for (const LinkPrediction &p : score_links(graph, pairs, kind)) {
+            auto first = graph.targets.begin() + graph.offsets[p.a], last = graph.targets.begin() + graph.offsets[p.a + 1];
+            result["pairs"].push_back({
+                {"a", entries[p.a].name},
+                {"b", entries[p.b].name},
+                {"score", p.score},
+                {"common", p.common},
+                {"linked", std::binary_search(first, last, p.b)}
+            });
+            add_edge(p);
+        }
+    } else {
+        std::vector<uint32_t> rows;
+        if (options.count("for")) {
+            int found = find_entry(entries, options.at("for"));
+            if (found < 0) {
+                std::cerr << "No contact named " << options.at("for") << std::endl;
+                return false;
+            }
+            rows.push_back(static_cast<uint32_t>(found));
+        }
+        // each pair once, from whichever side ranked it
+        std::set<std::pair<uint32_t, uint32_t>> seen;
+        for (const auto &row : predict_links(graph, k, kind, rows)) {
+            for (const LinkPrediction &p : row) {
+                if (seen.insert({std::min(p.a, p.b), std::max(p.a, p.b)}).second) add_edge(p);
+            }
+        }
+    }
+
+    for (uint32_t u : shown) {
+        result["nodes"].push_back({{"id", entries[u].name}, {"name", entries[u].name}, {"location", entries[u].location}});
+    }
+    result["score"] = scoreName;
+    return true;
 }
 
 
-json generate_edges_by_shared_goals(const std::string &db_path = "goals_edges.db") {
+// "cores": every contact's core number on the composite graph (or --layers) and on each layer
+// with non-zero weight, i.e. the largest k for which they sit in a group where everyone has k
+// links inside it. "layers" has each graph's degeneracy (its highest core) and how many people
+// are in each k-core, k = 1 up to it.
+json generate_edges_by_cores(const std::vector<entry> &entries, const CompositeWeights &weights) {
     json result;
     result["nodes"] = json::array();
     result["edges"] = json::array();
+    result["layers"] = json::object();
+
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    std::vector<std::string> names;
+    std::vector<std::vector<uint32_t>> cores;
+    auto peel = [&](const std::string &name, const CompositeWeights &w) {
+        ContactGraph contacts = build_contact_graph(entries, w);
+        names.push_back(name);
+        cores.push_back(core_numbers(build_csr(n, contacts.edges)));
+
+        const std::vector<uint32_t> &core = cores.back();
+        uint32_t degeneracy = core.empty() ? 0 : *std::max_element(core.begin(), core.end());
+        std::vector<uint32_t> sizes(degeneracy + 1, 0);
+        for (uint32_t c : core) ++sizes[c];
+        for (uint32_t k = degeneracy; k-- > 1;) sizes[k] += sizes[k + 1];   // k-core holds every shell >= k
+        result["layers"][name] = {
+            {"degeneracy", degeneracy},
+            {"core_sizes", std::vector<uint32_t>(sizes.begin() + std::min<size_t>(1, sizes.size()), sizes.end())}
+        };
+    };
+
+    peel("composite", weights);
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        if (weights.weight[layer] != 0.0) peel(LAYER_NAMES[layer], single_layer(layer));
+    }
 
-    sqlite3 *db;
-    if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return result;
+    for (uint32_t i = 0; i < n; ++i) {
+        json byLayer = json::object();
+        for (size_t l = 0; l < names.size(); ++l) byLayer[names[l]] = cores[l][i];
+        result["nodes"].push_back({
+            {"id", entries[i].name},
+            {"name", entries[i].name},
+            {"location", entries[i].location},
+            {"core", cores[0][i]},
+            {"layer_cores", byLayer}
+        });
     }
+    return result;
+}
 
-    const char *query = "SELECT person1, person2, shared_goal FROM share_goals;";
-    sqlite3_stmt *stmt;
 
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return result;
+// --kcore=k on any view: keeps only the view's own k-core, the nodes that still have k links
+// after everyone with fewer is dropped (repeatedly), and the edges between them. Kept nodes
+// get their "core" number. Edges are matched to nodes by id, in either direction.
+void keep_kcore(json &result, uint32_t k) {
+    if (!result.contains("nodes") || !result["nodes"].is_array() || !result.contains("edges") ||
+        !result["edges"].is_array()) {
+        return;
     }
 
-    std::set<std::string> unique_nodes;
+    std::unordered_map<std::string, uint32_t> index;
+    for (uint32_t i = 0; i < result["nodes"].size(); ++i) {
+        const json &node = result["nodes"][i];
+        if (node.contains("id")) index.emplace(node["id"].dump(), i);
+    }
+    auto find = [&](const json &edge, const char *end) -> int64_t {
+        if (!edge.contains(end)) return -1;
+        auto it = index.find(edge[end].dump());
+        return it == index.end() ? -1 : static_cast<int64_t>(it->second);
+    };
+
+    // views list some links once per direction; the graph wants each pair once
+    std::vector<GraphEdge> edges;
+    std::set<std::pair<uint32_t, uint32_t>> pairs;
+    for (const auto &edge : result["edges"]) {
+        int64_t a = find(edge, "source"), b = find(edge, "target");
+        if (a < 0 || b < 0 || a == b) continue;
+        std::pair<uint32_t, uint32_t> pair(static_cast<uint32_t>(std::min(a, b)), static_cast<uint32_t>(std::max(a, b)));
+        if (pairs.insert(pair).second) edges.push_back({pair.first, pair.second, 1.0f});
+    }
+    std::vector<uint32_t> core = core_numbers(build_csr(static_cast<uint32_t>(result["nodes"].size()), edges));
+
+    json nodes = json::array(), kept = json::array();
+    for (size_t i = 0; i < core.size(); ++i) {
+        if (core[i] < k) continue;
+        json node = result["nodes"][i];
+        node["core"] = core[i];
+        nodes.push_back(node);
+    }
+    for (const auto &edge : result["edges"]) {
+        int64_t a = find(edge, "source"), b = find(edge, "target");
+        if (a >= 0 && b >= 0 && core[a] >= k && core[b] >= k) kept.push_back(edge);
+    }
+    result["nodes"] = nodes;
+    result["edges"] = kept;
+    result["kcore"] = k;
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string person1 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        std::string person2 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-        std::string goal = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
 
-        if (unique_nodes.insert(person1).second) {
-            result["nodes"].push_back({{"id", person1}});
+struct CentralityScores {
+    std::vector<float> pagerank;      // per entry, sums to 1
+    std::vector<float> eigenvector;   // per entry, top score 1
+    bool cached = false;
+};
+
+
+// PageRank and eigenvector centrality of every contact on the composite graph. Scores are kept
+// in graph_cache.db under graph_version(), so they are only recomputed after the contacts (or
+// the weights asked for) change; rows from older contents are dropped when new ones are written.
+// With compute false a cache miss returns no scores instead of building the graph.
+CentralityScores centrality_scores(const std::vector<entry> &entries, const CompositeWeights &weights, bool compute = true) {
+    CentralityScores scores;
+    std::string version = graph_version(entries, weights);
+    size_t n = entries.size();
+
+    sqlite3 *db = open_graph_cache();
+    bool ready = db != nullptr;
+
+    sqlite3_stmt *stmt;
+    if (ready && sqlite3_prepare_v2(db, "SELECT contact, pagerank, eigenvector FROM centrality WHERE graph_version = ?;",
+                                    -1, &stmt, nullptr) == SQLITE_OK) {
+        scores.pagerank.assign(n, -1.0f);
+        scores.eigenvector.assign(n, 0.0f);
+        size_t found = 0;
+        sqlite3_bind_text(stmt, 1, version.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            sqlite3_int64 i = sqlite3_column_int64(stmt, 0);
+            if (i < 0 || static_cast<size_t>(i) >= n) continue;
+            scores.pagerank[i] = static_cast<float>(sqlite3_column_double(stmt, 1));
+            scores.eigenvector[i] = static_cast<float>(sqlite3_column_double(stmt, 2));
+            ++found;
         }
-        if (unique_nodes.insert(person2).second) {
-            result["nodes"].push_back({{"id", person2}});
+        sqlite3_finalize(stmt);
+        if (found == n) {
+            scores.cached = true;
+            sqlite3_close(db);
+            return scores;
         }
+    }
+    if (!compute) {
+        scores.pagerank.clear();
+        scores.eigenvector.clear();
+        sqlite3_close(db);
+        return scores;
+    }
 
-        result["edges"].push_back({
-            {"source", person1},
-            {"target", person2},
-            {"label", goal}
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    CsrGraph graph = build_csr(static_cast<uint32_t>(n), contacts.edges);
+    scores.pagerank = pagerank(graph);
+    scores.eigenvector = eigenvector_centrality(graph);
+
+    if (ready && sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+        bool ok = drop_stale_versions(db, "centrality", version);
+        if (ok && sqlite3_prepare_v2(db, "INSERT INTO centrality (graph_version, contact, pagerank, eigenvector) VALUES (?, ?, ?, ?);",
+                                     -1, &stmt, nullptr) == SQLITE_OK) {
+            for (size_t i = 0; ok && i < n; ++i) {
+                sqlite3_bind_text(stmt, 1, version.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(i));
+                sqlite3_bind_double(stmt, 3, scores.pagerank[i]);
+                sqlite3_bind_double(stmt, 4, scores.eigenvector[i]);
+                ok = sqlite3_step(stmt) == SQLITE_DONE;
+                sqlite3_reset(stmt);
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+        if (!ok) std::cerr << "Could not cache centrality: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_close(db);
+    return scores;
+}
+
+
+// adds pagerank and eigenvector to every node of a view that names a contact
+void add_centrality(json &result, const std::vector<entry> &entries, const CentralityScores &scores) {
+    if (scores.pagerank.size() != entries.size()) return;
+    if (!result.contains("nodes") || !result["nodes"].is_array()) return;
+
+    // group views name people with the spaces taken out (split_people), so index both spellings
+    std::unordered_map<std::string, uint32_t> index;
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        std::string compact = entries[i].name;
+        compact.erase(std::remove_if(compact.begin(), compact.end(), ::isspace), compact.end());
+        index.emplace(entries[i].name, i);
+        index.emplace(compact, i);
+    }
+
+    for (auto &node : result["nodes"]) {
+        const json &key = node.contains("name") && node["name"].is_string() ? node["name"] : node["id"];
+        if (!key.is_string()) continue;
+        auto it = index.find(key.get<std::string>());
+        if (it == index.end()) continue;
+        node["pagerank"] = scores.pagerank[it->second];
+        node["eigenvector"] = scores.eigenvector[it->second];
+    }
+}
+
+
+// "centrality": the --k (default 20) most influential contacts by PageRank over the composite
+// graph or --layers, with their eigenvector centrality alongside.
+bool generate_edges_by_centrality(const std::vector<entry> &entries, const std::map<std::string, std::string> &options,
+                                  const CompositeWeights &weights, json &result) {
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
+
+    OptionReader option(options);
+    size_t k = option.count("k", 20, 1);
+    if (!option.ok()) return false;
+
+    CentralityScores scores = centrality_scores(entries, weights);
+    std::vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+        return scores.pagerank[x] > scores.pagerank[y];
+    });
+    if (order.size() > k) order.resize(k);
+
+    for (uint32_t i : order) {
+        result["nodes"].push_back({
+            {"id", entries[i].name},
+            {"name", entries[i].name},
+            {"location", entries[i].location},
+            {"pagerank", scores.pagerank[i]},
+            {"eigenvector", scores.eigenvector[i]}
+        });
+    }
+    result["cached"] = scores.cached;
+    return true;
+}
+
+
+// "brokers": the --k (default 20) contacts who sit on the most shortest paths between others
+// over the composite graph or --layers, the people who bridge circles that don't otherwise
+// meet. Betweenness is sampled until every score is within --epsilon (default 0.01, as a share
+// of all paths) with probability 1 - --delta (default 0.1), or --budget (default 10) seconds
+// have passed, or --samples sources (no cap by default) have been searched. "error" is the bound
+// reached and "bound_met" whether it got to epsilon. Edges among the brokers come along.
+bool generate_edges_by_brokers(const std::vector<entry> &entries, const std::map<std::string, std::string> &options,
+                               const CompositeWeights &weights, json &result) {
+    result["nodes"] = json::array();
+    result["edges"] = json::array();
+
+    OptionReader option(options);
+    size_t k = option.count("k", 20, 1);
+    double epsilon = option.number("epsilon", 0.01, 0, 1), delta = option.number("delta", 0.1, 0, 1);
+    size_t samples = option.count("samples", 0);
+    double budget = option.number("budget", 10, 0);
+    if (!option.ok()) return false;
+    if (epsilon == 0.0 || delta == 0.0 || delta == 1.0) {
+        std::cerr << "--epsilon must be positive and --delta between 0 and 1" << std::endl;
+        return false;
+    }
+
+    ContactGraph contacts = cached_contact_graph(entries, weights);
+    CsrGraph graph = build_csr(static_cast<uint32_t>(entries.size()), contacts.edges);
+    Betweenness found = betweenness_sampled(graph, epsilon, delta, samples, budget);
+
+    std::vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+        return found.score[x] > found.score[y];
+    });
+    if (order.size() > k) order.resize(k);
+
+    std::vector<bool> broker(entries.size(), false);
+    for (uint32_t i : order) {
+        broker[i] = true;
+        result["nodes"].push_back({
+            {"id", entries[i].name},
+            {"name", entries[i].name},
+            {"location", entries[i].location},
+            {"betweenness", found.score[i]},
+            {"degree", graph.degree(i)}
         });
+    }
+    for (uint32_t e = 0; e < contacts.edges.size(); ++e) {
+        const GraphEdge &edge = contacts.edges[e];
+        if (!broker[edge.a] || !broker[edge.b]) continue;
         result["edges"].push_back({
-            {"source", person2},
-            {"target", person1},
-            {"label", goal}
+            {"source", entries[edge.a].name},
+            {"target", entries[edge.b].name},
+            {"weight", edge.weight},
+            {"label", contacts.edge_label(e)},
+            {"undirected", true}
         });
     }
+    result["samples"] = found.samples;
+    result["error"] = found.error;
+    result["epsilon"] = epsilon;
+    result["bound_met"] = found.bound_met;
+    result["exact"] = found.exact;
+    return true;
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 
-    std::cout << result.dump(2) << std::endl;
+// every view "all" warms, in output order
+const char* ALL_FEATURES[] = {
+    "location", "current_company", "previous_companies", "industry", "interests", "college",
+    "high_school", "career_goals", "skills", "talent_rating", "closeness", "composite"
+};
 
-    return result;
+
+// builds one view into result; false (with the reason on stderr) for an unknown view or bad options
+bool build_feature(const std::string &feature_column, const std::vector<entry> &all_entries,
+                   const std::map<std::string, std::string> &options, json &result) {
+    if (feature_column == "") {
+        result = generate_edges_by_default(all_entries);
+    } else if (feature_column == "location") {
+        result = generate_edges_by_location(all_entries);
+    } else if (feature_column == "current_company") {
+        result = generate_edges_by_current_company();
+    } else if (feature_column == "previous_companies") {
+        result = generate_edges_by_previous_company();
+    } else if (feature_column == "industry") {
+        result = generate_edges_by_industry();
+    } else if (feature_column == "interests") {
+        result = generate_edges_by_shared_interests();
+    } else if (feature_column == "college") {
+        result = generate_edges_by_college();
+    } else if (feature_column == "high_school") {
+        result = generate_edges_by_high_school();
+    } else if (feature_column == "career_goals") {
+        result = generate_edges_by_shared_goals();
+    } else if (feature_column == "skills") {
+        result = generate_edges_by_shared_skills();
+    } else if (feature_column == "talent_rating") {
+        result = generate_edges_by_talent(all_entries);
+    } else if (feature_column == "closeness") {
+        result = generate_edges_by_closeness(all_entries);
+    } else if (feature_column == "composite") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        result = generate_edges_by_composite(all_entries, weights);
+    } else if (feature_column.rfind("similar/", 0) == 0) {
+        OptionReader option(options);
+        size_t k = option.count("k", 10, 1);
+        if (!option.ok()) return false;
+        result = generate_edges_by_similarity(feature_column.substr(8), k);
+    } else if (feature_column == "components") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        result = generate_edges_by_components(all_entries, weights);
+    } else if (feature_column == "communities") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_communities(all_entries, options, weights, result);
+    } else if (feature_column == "cores") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        result = generate_edges_by_cores(all_entries, weights);
+    } else if (feature_column == "triangles") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        result = generate_edges_by_triangles(all_entries, weights);
+    } else if (feature_column == "centrality") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_centrality(all_entries, options, weights, result);
+    } else if (feature_column == "brokers") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_brokers(all_entries, options, weights, result);
+    } else if (feature_column.rfind("ego/", 0) == 0) {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_ego(feature_column.substr(4), all_entries, options, weights, result);
+    } else if (feature_column == "links") {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_links(all_entries, options, weights, result);
+    } else if (feature_column == "meet" || feature_column.rfind("meet/", 0) == 0) {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_meet(feature_column.size() > 5 ? feature_column.substr(5) : "", all_entries, options, weights, result);
+    } else if (feature_column.rfind("path/", 0) == 0) {
+        CompositeWeights weights;
+        if (!composite_options(options, weights)) return false;
+        return generate_edges_by_path(feature_column.substr(5), all_entries, options, weights, result);
+    } else {
+        std::cerr << "Unknown feature column: " << feature_column << std::endl;
+        return false;
+    }
+    return true;
 }
 
 
 int main(int argc, char* argv[]) {
     //std::cout << "[DEBUG] Entered main()\n";
 
-    if (argc != 2) {
-        std::cerr << "Usage: ./generate_edges <feature_column>" << std::endl;
+    if (argc < 2) {
+        std::cerr << "Usage: ./generate_edges <feature_column> [--option=value ...]" << std::endl;
+        std::cerr << "       ./generate_edges --refresh    recompute graph_cache.db after contacts change" << std::endl;
         return 1;
     }
 
     std::string feature_column = argv[1];
+    std::map<std::string, std::string> options = parse_options(argc, argv, 2);
     sqlite3* db;
-    if (sqlite3_open("my_database.db", &db)) {
+    if (sqlite3_open_v2("my_database.db", &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
         std::cerr << "Can't open DB\n";
+        sqlite3_close(db);
         return 1;
     }
 
     std::vector<entry> all_entries;
 
+    // company and school columns are read as their canonical organizations, so "Google LLC" and
+    // "Google" land in the same layer; a database nobody has resolved yet gives the raw columns
+    bool resolved = has_organization_tables(db);
+    auto column = [resolved](const std::string &raw, const std::string &field) {
+        return resolved ? canonical_column(raw, field) : raw;
+    };
+
     std::string query = R"(
         SELECT 
             contacts.name, contacts.email, contacts.phone, contacts.location,
-            employment.current_company, employment.previous_companies, employment.industry, employment.job_title,
+            )" + column("employment.current_company", "current_company") + ", " +
+                 column("employment.previous_companies", "previous_companies") + R"(,
+            employment.industry, employment.job_title,
             relationships.relationship_type, relationships.closeness, relationships.reliability,
-            profile.career_goals, profile.skills, profile.talent_rating
+            profile.career_goals, profile.skills, profile.talent_rating,
+            background.interests, )" + column("background.college", "college") + ", " +
+                 column("background.high_school", "high_school") + R"(
         FROM contacts
         LEFT JOIN employment ON contacts.id = employment.contact_id
         LEFT JOIN background ON contacts.id = background.contact_id
@@ -956,6 +2268,9 @@ int main(int argc, char* argv[]) {
         e.careerGoals   = getSafeText(stmt, 11);
         e.skills        = getSafeText(stmt, 12);
         e.talent        = getSafeText(stmt, 13);
+        e.interests     = getSafeText(stmt, 14);
+        e.college       = getSafeText(stmt, 15);
+        e.highSchool    = getSafeText(stmt, 16);
         all_entries.push_back(e);
     }
 
@@ -964,39 +2279,76 @@ int main(int argc, char* argv[]) {
 
     //generate_edges_by_location(all_entries);
 
-    // 🔧 Use the feature_column to route to specific logic (hooked here)
-    if (feature_column == "") {
-        generate_edges_by_default(all_entries);
-    } else if (feature_column == "location") {
-        generate_edges_by_location(all_entries);
-    } else if (feature_column == "current_company") {
-        generate_edges_by_current_company();
-    } else if (feature_column == "previous_companies") {
-        generate_edges_by_previous_company();
-    } else if (feature_column == "industry") {
-        generate_edges_by_industry();
-    } else if (feature_column == "interests") {
-        generate_edges_by_shared_interests();
-    } else if (feature_column == "college") {
-        generate_edges_by_college();
-    } else if (feature_column == "high_school") {
-        generate_edges_by_high_school();
-    } else if (feature_column == "career_goals") {
-        generate_edges_by_shared_goals();
-    } else if (feature_column == "skills") {
-        generate_edges_by_shared_skills();
-    } else if (feature_column == "talent_rating") {
-        generate_edges_by_talent(all_entries);
-    } else if (feature_column == "closeness") {
-        generate_edges_by_closeness(all_entries);
+    // several views can be asked for at once ("college,skills" or "all"); each builds on the
+    // shared pool with its own connection and result, and the output is stitched back in order
+    std::vector<std::string> features;
+    if (feature_column == "all") {
+        features.assign(std::begin(ALL_FEATURES), std::end(ALL_FEATURES));
     } else {
-        std::cerr << "Unknown feature column: " << feature_column << std::endl;
-        return 1;
+        std::stringstream ss(feature_column);
+        std::string feature;
+        while (std::getline(ss, feature, ',')) features.push_back(feature);
+        if (features.empty()) features.push_back("");
     }
+
+    // app.py runs this after every contact change, so requests below only read the cache
+    if (feature_column == "--refresh") {
+        ContactGraph graph = cached_contact_graph(all_entries, CompositeWeights());
+        CentralityScores fresh = centrality_scores(all_entries, CompositeWeights());
+        std::cout << "Graph cache " << (fresh.cached ? "already current" : "refreshed") << " for "
+                  << all_entries.size() << " contacts, " << graph.edges.size() << " edges." << std::endl;
+        return 0;
+    }
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // every view's people get the composite graph's influence scores when graph_cache.db has
+    // them for these contacts; a stale cache leaves the nodes as they are until --refresh runs
+    CentralityScores scores = centrality_scores(all_entries, CompositeWeights(), false);
+
+    // --kcore=k trims whatever a view returns down to its k-core
+    OptionReader option(options);
+    bool trim = option.has("kcore");
+    uint32_t kcore = static_cast<uint32_t>(option.count("kcore", 0));
+    if (!option.ok()) return 1;
+    auto finish = [&](json &result) {
+        if (trim) keep_kcore(result, kcore);
+        add_centrality(result, all_entries, scores);
+    };
+
+    if (features.size() == 1) {
+        json result;
+        if (!build_feature(features[0], all_entries, options, result)) return 1;
+        finish(result);
+        std::cout << result.dump(2) << std::endl;
+        return 0;
+    }
+
+    std::vector<json> results(features.size());
+    std::vector<std::future<bool>> pending;
+    for (size_t i = 0; i < features.size(); ++i) {
+        pending.push_back(shared_pool().submit([&, i] {
+            return build_feature(features[i], all_entries, options, results[i]);
+        }));
+    }
+
+    bool ok = true;
+    for (auto &p : pending) ok = p.get() && ok;
+    if (!ok) return 1;
+    for (auto &result : results) finish(result);
+
+    // written by hand so the keys keep the requested order (json objects sort them)
+    std::cout << "{" << std::endl;
+    for (size_t i = 0; i < features.size(); ++i) {
+        std::cout << json(features[i]).dump() << ": " << results[i].dump(2)
+                  << (i + 1 < features.size() ? "," : "") << std::endl;
+    }
+    std::cout << "}" << std::endl;
+
     return 0;
 }
 
 /* Compile using:
     gcc -c sqlite3.c -o sqlite3.o
-    g++ generate_edges.cpp sqlite3.o -o generate_edges -g -I. -I./curl -I./nlohmann -L./lib -lcurl -lssl -lcrypto -lz -lws2_32 -lbrotlidec -lbrotlicommon
+    g++ generate_edges.cpp sqlite3.o -o generate_edges -g -I. -I./curl -I./nlohmann -L./lib -lcurl -lssl -lcrypto -lz -lws2_32 -lbrotlidec -lbrotlicommon -pthread
 */
@@ -0,0 +1,1340 @@
+#ifndef GRAPH_ALGORITHMS_H
+#define GRAPH_ALGORITHMS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "bitset_kernels.h"
+#include "thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GRAPH_ALGORITHMS_X86 1
+#endif
+
+// Graph queries over the contact network. Views build an undirected graph once per request as
+// compressed sparse rows (CSR): every node's neighbours sit in one contiguous, sorted slice of
+// `targets`, so a traversal is a scan over flat arrays instead of a walk over maps.
+
+
+struct GraphEdge {
+    uint32_t a;
+    uint32_t b;
+    float weight;
+};
+
+
+struct CsrGraph {
+    std::vector<uint64_t> offsets;   // node u's arcs are [offsets[u], offsets[u + 1])
+    std::vector<uint32_t> targets;   // sorted within each row
+    std::vector<float> weights;
+    std::vector<uint32_t> edges;     // index into the GraphEdge list, shared by both directions
+
+    uint32_t node_count() const { return offsets.empty() ? 0 : static_cast<uint32_t>(offsets.size() - 1); }
+    size_t arc_count() const { return targets.size(); }
+    uint32_t degree(uint32_t u) const { return static_cast<uint32_t>(offsets[u + 1] - offsets[u]); }
+};
+
+
+// Both directions of every edge; self loops are dropped. Edges are expected to be unique
+// (one per pair), duplicates would show up as parallel arcs.
+inline CsrGraph build_csr(uint32_t nodes, const std::vector<GraphEdge> &edges) {
+    CsrGraph g;
+    g.offsets.assign(static_cast<size_t>(nodes) + 1, 0);
+    for (const GraphEdge &e : edges) {
+        if (e.a == e.b) continue;
+        ++g.offsets[e.a + 1];
+        ++g.offsets[e.b + 1];
+    }
+    for (uint32_t u = 0; u < nodes; ++u) g.offsets[u + 1] += g.offsets[u];
+
+    size_t arcs = g.offsets[nodes];
+    g.targets.resize(arcs);
+    g.weights.resize(arcs);
+    g.edges.resize(arcs);
+
+    std::vector<uint64_t> fill(g.offsets.begin(), g.offsets.end() - 1);
+    for (uint32_t i = 0; i < edges.size(); ++i) {
+        const GraphEdge &e = edges[i];
+        if (e.a == e.b) continue;
+        uint64_t x = fill[e.a]++, y = fill[e.b]++;
+        g.targets[x] = e.b; g.weights[x] = e.weight; g.edges[x] = i;
+        g.targets[y] = e.a; g.weights[y] = e.weight; g.edges[y] = i;
+    }
+
+    // sort each row by target, carrying weight and edge id along
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> targets;
+    std::vector<float> weights;
+    std::vector<uint32_t> ids;
+    for (uint32_t u = 0; u < nodes; ++u) {
+        uint64_t begin = g.offsets[u], end = g.offsets[u + 1];
+        if (std::is_sorted(g.targets.begin() + begin, g.targets.begin() + end)) continue;
+
+        order.resize(end - begin);
+        for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+            return g.targets[begin + x] < g.targets[begin + y];
+        });
+        targets.assign(g.targets.begin() + begin, g.targets.begin() + end);
+        weights.assign(g.weights.begin() + begin, g.weights.begin() + end);
+        ids.assign(g.edges.begin() + begin, g.edges.begin() + end);
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            g.targets[begin + i] = targets[order[i]];
+            g.weights[begin + i] = weights[order[i]];
+            g.edges[begin + i] = ids[order[i]];
+        }
+    }
+    return g;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Paths
+
+struct GraphPath {
+    std::vector<uint32_t> nodes;   // source first, target last
+    std::vector<uint32_t> edges;   // edge ids, one per hop
+    double cost = 0.0;             // hop count, or summed weights for cheapest_path
+
+    bool empty() const { return nodes.empty(); }
+};
+
+
+// Nodes and edges a search must not use; Yen's algorithm bans them to force a detour.
+struct PathBans {
+    std::vector<char> nodes;
+    std::unordered_set<uint32_t> edges;
+
+    bool node(uint32_t u) const { return u < nodes.size() && nodes[u]; }
+    bool edge(uint32_t e) const { return !edges.empty() && edges.count(e) > 0; }
+};
+
+
+// Fewest hops from s to t. Searches from both ends and always grows the smaller frontier by
+// a whole level, so it touches about 2 * b^(d/2) nodes instead of b^d. Empty if unreachable.
+inline GraphPath shortest_hops(const CsrGraph &g, uint32_t s, uint32_t t, const PathBans *bans = nullptr) {
+    GraphPath path;
+    if (bans && (bans->node(s) || bans->node(t))) return path;
+    if (s == t) {
+        path.nodes.push_back(s);
+        return path;
+    }
+
+    const uint64_t NONE = std::numeric_limits<uint64_t>::max();
+    uint32_t n = g.node_count();
+    // side[u]: 0 unseen, 1 reached from s, 2 reached from t; via[u] is the arc it was reached by
+    std::vector<uint8_t> side(n, 0);
+    std::vector<uint64_t> via(n, NONE);
+    std::vector<uint32_t> parent(n, UINT32_MAX);
+    std::vector<uint32_t> frontier[2] = {{s}, {t}};
+    side[s] = 1;
+    side[t] = 2;
+
+    uint32_t meetFrom = UINT32_MAX, meetTo = UINT32_MAX;
+    uint64_t meetArc = NONE;
+    std::vector<uint32_t> next;
+
+    while (meetArc == NONE && !frontier[0].empty() && !frontier[1].empty()) {
+        int grow = frontier[0].size() <= frontier[1].size() ? 0 : 1;
+        uint8_t mine = static_cast<uint8_t>(grow + 1), theirs = static_cast<uint8_t>(2 - grow);
+        next.clear();
+
+        for (uint32_t u : frontier[grow]) {
+            for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+                uint32_t v = g.targets[arc];
+                if (side[v] == mine) continue;
+                if (bans && (bans->node(v) || bans->edge(g.edges[arc]))) continue;
+                if (side[v] == theirs) {
+                    meetFrom = grow == 0 ? u : v;
+                    meetTo = grow == 0 ? v : u;
+                    meetArc = arc;
+                    break;
+                }
+                side[v] = mine;
+                via[v] = arc;
+                parent[v] = u;
+                next.push_back(v);
+            }
+            if (meetArc != NONE) break;
+        }
+        frontier[grow].swap(next);
+    }
+    if (meetArc == NONE) return path;
+
+    // s ... meetFrom, then meetTo ... t
+    for (uint32_t u = meetFrom; u != UINT32_MAX; u = parent[u]) {
+        path.nodes.push_back(u);
+        if (via[u] != NONE) path.edges.push_back(g.edges[via[u]]);
+    }
+    std::reverse(path.nodes.begin(), path.nodes.end());
+    std::reverse(path.edges.begin(), path.edges.end());
+    path.edges.push_back(g.edges[meetArc]);
+    for (uint32_t u = meetTo; u != UINT32_MAX; u = parent[u]) {
+        path.nodes.push_back(u);
+        if (via[u] != NONE) path.edges.push_back(g.edges[via[u]]);
+    }
+    path.cost = static_cast<double>(path.edges.size());
+    return path;
+}
+
+
+// Cheapest path from s to t with arc weights read as non-negative costs (Dijkstra, stopping
+// as soon as t is settled). Empty if unreachable.
+inline GraphPath cheapest_path(const CsrGraph &g, uint32_t s, uint32_t t, const PathBans *bans = nullptr) {
+    GraphPath path;
+    if (bans && (bans->node(s) || bans->node(t))) return path;
+
+    const double INF = std::numeric_limits<double>::infinity();
+    const uint64_t NONE = std::numeric_limits<uint64_t>::max();
+    uint32_t n = g.node_count();
+    std::vector<double> dist(n, INF);
+    std::vector<uint64_t> via(n, NONE);
+    std::vector<uint32_t> parent(n, UINT32_MAX);
+
+    typedef std::pair<double, uint32_t> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    dist[s] = 0.0;
+    queue.push({0.0, s});
+
+    while (!queue.empty()) {
+        Item top = queue.top();
+        queue.pop();
+        uint32_t u = top.second;
+        if (top.first > dist[u]) continue;
+        if (u == t) break;
+
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            uint32_t v = g.targets[arc];
+            if (bans && (bans->node(v) || bans->edge(g.edges[arc]))) continue;
+            double d = dist[u] + g.weights[arc];
+            if (d < dist[v]) {
+                dist[v] = d;
+                via[v] = arc;
+                parent[v] = u;
+                queue.push({d, v});
+            }
+        }
+    }
+    if (dist[t] == INF) return path;
+
+    for (uint32_t u = t; u != UINT32_MAX; u = parent[u]) {
+        path.nodes.push_back(u);
+        if (via[u] != NONE) path.edges.push_back(g.edges[via[u]]);
+    }
+    std::reverse(path.nodes.begin(), path.nodes.end());
+    std::reverse(path.edges.begin(), path.edges.end());
+    path.cost = dist[t];
+    return path;
+}
+
+
+// The k best loopless paths from s to t, best first (Yen's algorithm). Each later path is the
+// cheapest detour that leaves an earlier one at some node and never reuses the prefix's nodes
+// or the edges earlier paths took from there. weighted picks cheapest_path over shortest_hops.
+inline std::vector<GraphPath> k_best_paths(const CsrGraph &g, uint32_t s, uint32_t t, size_t k, bool weighted) {
+    auto search = [&](uint32_t from, const PathBans *bans) {
+        return weighted ? cheapest_path(g, from, t, bans) : shortest_hops(g, from, t, bans);
+    };
+    // cost of the first `hops` hops of p, recomputed from the arcs so both modes agree
+    auto prefix_cost = [&](const GraphPath &p, size_t hops) {
+        if (!weighted) return static_cast<double>(hops);
+        double cost = 0.0;
+        for (size_t i = 0; i < hops; ++i) {
+            uint32_t u = p.nodes[i];
+            for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+                if (g.edges[arc] == p.edges[i]) {
+                    cost += g.weights[arc];
+                    break;
+                }
+            }
+        }
+        return cost;
+    };
+
+    std::vector<GraphPath> best;
+    if (k == 0 || s >= g.node_count() || t >= g.node_count()) return best;
+
+    GraphPath first = search(s, nullptr);
+    if (first.empty()) return best;
+    best.push_back(first);
+
+    // candidates ordered by cost, then hops, then nodes so the output is deterministic
+    auto better = [](const GraphPath &x, const GraphPath &y) {
+        if (x.cost != y.cost) return x.cost < y.cost;
+        if (x.nodes.size() != y.nodes.size()) return x.nodes.size() < y.nodes.size();
+        return x.nodes < y.nodes;
+    };
+    std::vector<GraphPath> candidates;
+    std::set<std::vector<uint32_t>> seen = {first.nodes};
+
+    PathBans bans;
+    bans.nodes.assign(g.node_count(), 0);
+
+    while (best.size() < k) {
+        const GraphPath last = best.back();
+        for (size_t i = 0; i + 1 < last.nodes.size(); ++i) {
+            uint32_t spur = last.nodes[i];
+
+            bans.edges.clear();
+            for (const GraphPath &p : best) {
+                if (p.nodes.size() > i && std::equal(p.nodes.begin(), p.nodes.begin() + i + 1, last.nodes.begin())) {
+                    bans.edges.insert(p.edges[i]);
+                }
+            }
+            for (size_t j = 0; j < i; ++j) bans.nodes[last.nodes[j]] = 1;
+
+            GraphPath detour = search(spur, &bans);
+
+            for (size_t j = 0; j < i; ++j) bans.nodes[last.nodes[j]] = 0;
+            if (detour.empty()) continue;
+
+            GraphPath total;
+            total.nodes.assign(last.nodes.begin(), last.nodes.begin() + i);
+            total.nodes.insert(total.nodes.end(), detour.nodes.begin(), detour.nodes.end());
+            total.edges.assign(last.edges.begin(), last.edges.begin() + i);
+            total.edges.insert(total.edges.end(), detour.edges.begin(), detour.edges.end());
+            total.cost = prefix_cost(last, i) + detour.cost;
+
+            if (seen.insert(total.nodes).second) candidates.push_back(std::move(total));
+        }
+        if (candidates.empty()) break;
+
+        auto next = std::min_element(candidates.begin(), candidates.end(), better);
+        best.push_back(std::move(*next));
+        candidates.erase(next);
+    }
+    return best;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Neighbourhoods
+
+struct EgoNetwork {
+    std::vector<uint32_t> nodes;   // center first, then level by level
+    std::vector<uint32_t> hops;    // distance from the center, per entry of nodes
+    bool truncated = false;        // maxNodes cut a level short
+};
+
+
+// Everyone within maxHops of center, breadth first, stopping once maxNodes are in. When a level
+// doesn't fit, its people with the strongest link (highest arc weight) into the previous level
+// are kept, so a capped answer still shows the closest part of the neighbourhood.
+inline EgoNetwork ego_network(const CsrGraph &g, uint32_t center, uint32_t maxHops, size_t maxNodes) {
+    EgoNetwork ego;
+    if (center >= g.node_count() || maxNodes == 0) return ego;
+
+    std::vector<uint32_t> hop(g.node_count(), UINT32_MAX);
+    std::vector<float> strength(g.node_count(), 0.0f);
+    hop[center] = 0;
+    ego.nodes.push_back(center);
+    ego.hops.push_back(0);
+
+    std::vector<uint32_t> frontier = {center}, next;
+    for (uint32_t level = 1; level <= maxHops && !frontier.empty() && ego.nodes.size() < maxNodes; ++level) {
+        next.clear();
+        for (uint32_t u : frontier) {
+            for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+                uint32_t v = g.targets[arc];
+                if (hop[v] < level) continue;
+                if (hop[v] == UINT32_MAX) {
+                    hop[v] = level;
+                    next.push_back(v);
+                }
+                strength[v] = std::max(strength[v], g.weights[arc]);
+            }
+        }
+
+        size_t room = maxNodes - ego.nodes.size();
+        if (next.size() > room) {
+            std::sort(next.begin(), next.end(), [&](uint32_t x, uint32_t y) {
+                return strength[x] != strength[y] ? strength[x] > strength[y] : x < y;
+            });
+            next.resize(room);
+            ego.truncated = true;
+        }
+        std::sort(next.begin(), next.end());
+        for (uint32_t v : next) {
+            ego.nodes.push_back(v);
+            ego.hops.push_back(level);
+        }
+        frontier.swap(next);
+    }
+    return ego;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Components and cores
+
+// Union-find that many threads can unite() into at once without locks. A root is only ever
+// linked under a smaller id by compare-and-swap, so parents strictly decrease and no cycle can
+// form however the threads interleave; find() halves paths as it goes with the same CAS.
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(uint32_t n) : n_(n), parent_(new std::atomic<uint32_t>[n]) {
+        for (uint32_t i = 0; i < n; ++i) parent_[i].store(i, std::memory_order_relaxed);
+    }
+
+    uint32_t size() const { return n_; }
+
+    uint32_t find(uint32_t x) const {
+        for (;;) {
+            uint32_t p = parent_[x].load(std::memory_order_relaxed);
+            if (p == x) return x;
+            uint32_t grand = parent_[p].load(std::memory_order_relaxed);
+            if (grand != p) parent_[x].compare_exchange_weak(p, grand, std::memory_order_relaxed);
+            x = grand;
+        }
+    }
+
+    void unite(uint32_t a, uint32_t b) {
+        for (;;) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            // a can stop being a root between find() and here; then look again
+            uint32_t expected = a;
+            if (parent_[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+        }
+    }
+
+    // dense component ids numbered in order of each component's smallest member, and sizes
+    std::vector<uint32_t> components(std::vector<uint32_t> &sizes) const {
+        std::vector<uint32_t> id(n_), rootId(n_, UINT32_MAX);
+        sizes.clear();
+        for (uint32_t u = 0; u < n_; ++u) {
+            uint32_t root = find(u);
+            if (rootId[root] == UINT32_MAX) {
+                rootId[root] = static_cast<uint32_t>(sizes.size());
+                sizes.push_back(0);
+            }
+            id[u] = rootId[root];
+            ++sizes[id[u]];
+        }
+        return id;
+    }
+
+private:
+    uint32_t n_;
+    std::unique_ptr<std::atomic<uint32_t>[]> parent_;
+};
+
+
+// Core number of every node: the largest k such that the node is in a subgraph where everyone
+// has at least k neighbours (Batagelj & Zaversnik). Nodes sit in buckets by remaining degree
+// and are peeled lowest first; removing one moves each neighbour with a higher degree down a
+// bucket by swapping it with the first node of its bucket, so the whole run is O(n + m).
+inline std::vector<uint32_t> core_numbers(const CsrGraph &g) {
+    uint32_t n = g.node_count();
+    std::vector<uint32_t> degree(n), position(n), order(n);
+    uint32_t maxDegree = 0;
+    for (uint32_t u = 0; u < n; ++u) {
+        degree[u] = g.degree(u);
+        maxDegree = std::max(maxDegree, degree[u]);
+    }
+
+    // start[d] = first slot of bucket d in order
+    std::vector<uint32_t> start(maxDegree + 2, 0);
+    for (uint32_t u = 0; u < n; ++u) ++start[degree[u] + 1];
+    for (uint32_t d = 1; d <= maxDegree + 1; ++d) start[d] += start[d - 1];
+    {
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (uint32_t u = 0; u < n; ++u) {
+            position[u] = fill[degree[u]]++;
+            order[position[u]] = u;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t u = order[i];
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            uint32_t v = g.targets[arc];
+            if (degree[v] <= degree[u]) continue;
+            uint32_t d = degree[v], first = order[start[d]];
+            if (first != v) {
+                std::swap(order[position[v]], order[start[d]]);
+                std::swap(position[v], position[first]);
+            }
+            ++start[d];
+            --degree[v];
+        }
+    }
+    return degree;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Communities
+
+struct Communities {
+    std::vector<uint32_t> of;      // community per node, numbered largest first
+    std::vector<uint32_t> sizes;
+    double modularity = 0.0;
+    int levels = 0;                // aggregation rounds that improved modularity
+};
+
+
+// Modularity of a split of a weighted graph whose nodes may carry self loops (loop[u], counted
+// once). With loops all zero this is the usual Newman-Girvan Q.
+inline double modularity(const CsrGraph &g, const std::vector<double> &loop, const std::vector<uint32_t> &community,
+                         double resolution = 1.0) {
+    uint32_t n = g.node_count();
+    std::vector<double> total(n, 0.0);
+    double internal = 0.0, m2 = 0.0;
+    for (uint32_t u = 0; u < n; ++u) {
+        double strength = 2.0 * loop[u];
+        internal += 2.0 * loop[u];
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            strength += g.weights[arc];
+            if (community[g.targets[arc]] == community[u]) internal += g.weights[arc];
+        }
+        total[community[u]] += strength;
+        m2 += strength;
+    }
+    if (m2 == 0.0) return 0.0;
+
+    double expected = 0.0;
+    for (double t : total) expected += t * t;
+    return internal / m2 - resolution * expected / (m2 * m2);
+}
+
+
+// One level of Louvain local moving. Every pass, all nodes pick their best neighbouring
+// community in parallel against a snapshot; the proposals are then applied one at a time with
+// the gain checked against the live totals, so modularity never goes down the way it can when
+// parallel moves are applied blindly. Passes repeat until nothing moves or Q stops improving.
+inline bool louvain_local_moving(const CsrGraph &g, const std::vector<double> &loop, double resolution,
+                                 std::vector<uint32_t> &community) {
+    uint32_t n = g.node_count();
+    std::vector<double> strength(n, 0.0), total(n, 0.0);
+    std::vector<uint32_t> members(n, 0);
+    double m2 = 0.0;
+    for (uint32_t u = 0; u < n; ++u) {
+        strength[u] = 2.0 * loop[u];
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) strength[u] += g.weights[arc];
+        total[community[u]] += strength[u];
+        ++members[community[u]];
+        m2 += strength[u];
+    }
+    if (m2 == 0.0) return false;
+
+    // weight from u into each neighbouring community, gathered in a dense scratch row
+    auto best_move = [&](uint32_t u, std::vector<double> &into, std::vector<uint32_t> &touched) {
+        uint32_t own = community[u];
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            uint32_t c = community[g.targets[arc]];
+            if (into[c] == 0.0) touched.push_back(c);
+            into[c] += g.weights[arc];
+        }
+
+        uint32_t best = own;
+        double bestGain = into[own] - resolution * strength[u] * (total[own] - strength[u]) / m2;
+        for (uint32_t c : touched) {
+            if (c == own) continue;
+            double gain = into[c] - resolution * strength[u] * total[c] / m2;
+            if (gain > bestGain + 1e-12) {
+                best = c;
+                bestGain = gain;
+            }
+        }
+        // two singletons would just swap places forever; only the higher id moves
+        if (best != own && members[own] == 1 && members[best] == 1 && best > own) best = own;
+
+        for (uint32_t c : touched) into[c] = 0.0;
+        touched.clear();
+        return best;
+    };
+
+    double q = modularity(g, loop, community, resolution);
+    bool movedAny = false;
+    std::vector<uint32_t> proposal(n);
+    std::vector<double> into(n, 0.0);
+    std::vector<uint32_t> touched;
+
+    for (int pass = 0; pass < 32; ++pass) {
+        parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+            thread_local std::vector<double> scratch;
+            thread_local std::vector<uint32_t> seen;
+            if (scratch.size() < n) scratch.resize(n, 0.0);
+            for (size_t u = begin; u < end; ++u) proposal[u] = best_move(static_cast<uint32_t>(u), scratch, seen);
+        }, 512);
+
+        size_t moved = 0;
+        for (uint32_t u = 0; u < n; ++u) {
+            if (proposal[u] == community[u]) continue;
+            uint32_t target = best_move(u, into, touched);
+            if (target == community[u]) continue;
+
+            total[community[u]] -= strength[u];
+            --members[community[u]];
+            community[u] = target;
+            total[target] += strength[u];
+            ++members[target];
+            ++moved;
+        }
+        if (moved == 0) break;
+        movedAny = true;
+
+        double next = modularity(g, loop, community, resolution);
+        if (next - q < 1e-7) break;
+        q = next;
+    }
+    return movedAny;
+}
+
+
+// Multilevel Louvain (Blondel et al.): local moving, then every community becomes one node of a
+// smaller graph whose edge weights are the summed weights between communities, and again,
+// until a level changes nothing. Weights are read as similarities.
+inline Communities louvain(const CsrGraph &graph, double resolution = 1.0, int maxLevels = 16) {
+    Communities result;
+    uint32_t n = graph.node_count();
+    result.of.resize(n);
+    for (uint32_t u = 0; u < n; ++u) result.of[u] = u;
+
+    CsrGraph g = graph;
+    std::vector<double> loop(n, 0.0);
+
+    for (int level = 0; level < maxLevels; ++level) {
+        uint32_t size = g.node_count();
+        std::vector<uint32_t> community(size);
+        for (uint32_t u = 0; u < size; ++u) community[u] = u;
+        if (!louvain_local_moving(g, loop, resolution, community)) break;
+        ++result.levels;
+
+        // renumber the communities densely and map the original nodes through
+        std::vector<uint32_t> dense(size, UINT32_MAX);
+        uint32_t count = 0;
+        for (uint32_t u = 0; u < size; ++u) {
+            if (dense[community[u]] == UINT32_MAX) dense[community[u]] = count++;
+            community[u] = dense[community[u]];
+        }
+        for (uint32_t &c : result.of) c = community[c];
+
+        // aggregate: edges between communities summed, edges inside them folded into the loop
+        std::vector<std::vector<uint32_t>> groups(count);
+        for (uint32_t u = 0; u < size; ++u) groups[community[u]].push_back(u);
+
+        std::vector<double> nextLoop(count, 0.0);
+        std::vector<GraphEdge> edges;
+        std::vector<double> between(count, 0.0);
+        std::vector<uint32_t> touched;
+        for (uint32_t c = 0; c < count; ++c) {
+            for (uint32_t u : groups[c]) {
+                nextLoop[c] += loop[u];
+                for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+                    uint32_t d = community[g.targets[arc]];
+                    if (d == c) {
+                        nextLoop[c] += g.weights[arc] / 2.0;  // seen from both ends
+                    } else if (d > c) {
+                        if (between[d] == 0.0) touched.push_back(d);
+                        between[d] += g.weights[arc];
+                    }
+                }
+            }
+            for (uint32_t d : touched) {
+                edges.push_back({c, d, static_cast<float>(between[d])});
+                between[d] = 0.0;
+            }
+            touched.clear();
+        }
+
+        g = build_csr(count, edges);
+        loop.swap(nextLoop);
+        if (count == size) break;
+    }
+
+    // number communities largest first, ties by smallest member
+    uint32_t count = 0;
+    for (uint32_t c : result.of) count = std::max(count, c + 1);
+    std::vector<uint32_t> sizes(count, 0), first(count, UINT32_MAX);
+    for (uint32_t u = 0; u < n; ++u) {
+        ++sizes[result.of[u]];
+        first[result.of[u]] = std::min(first[result.of[u]], u);
+    }
+    std::vector<uint32_t> order(count), rank(count);
+    for (uint32_t c = 0; c < count; ++c) order[c] = c;
+    std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+        return sizes[x] != sizes[y] ? sizes[x] > sizes[y] : first[x] < first[y];
+    });
+    result.sizes.resize(count);
+    for (uint32_t r = 0; r < count; ++r) {
+        rank[order[r]] = r;
+        result.sizes[r] = sizes[order[r]];
+    }
+    for (uint32_t &c : result.of) c = rank[c];
+
+    result.modularity = modularity(graph, std::vector<double>(n, 0.0), result.of, resolution);
+    return result;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Centrality
+
+// y[u] = sum over u's arcs of weight * x[target], for rows [begin, end). Unweighted counts every
+// arc as 1. The row loop is kept to a plain gather-multiply-add so it vectorizes.
+inline void spmv_rows_scalar(const CsrGraph &g, const float *x, float *y, uint32_t begin, uint32_t end, bool weighted) {
+    for (uint32_t u = begin; u < end; ++u) {
+        // four partial sums break the add dependency chain
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        uint64_t arc = g.offsets[u], last = g.offsets[u + 1];
+        const uint32_t *t = g.targets.data();
+        const float *w = g.weights.data();
+        if (weighted) {
+            for (; arc + 4 <= last; arc += 4) {
+                s0 += w[arc] * x[t[arc]];
+                s1 += w[arc + 1] * x[t[arc + 1]];
+                s2 += w[arc + 2] * x[t[arc + 2]];
+                s3 += w[arc + 3] * x[t[arc + 3]];
+            }
+            for (; arc < last; ++arc) s0 += w[arc] * x[t[arc]];
+        } else {
+            for (; arc + 4 <= last; arc += 4) {
+                s0 += x[t[arc]];
+                s1 += x[t[arc + 1]];
+                s2 += x[t[arc + 2]];
+                s3 += x[t[arc + 3]];
+            }
+            for (; arc < last; ++arc) s0 += x[t[arc]];
+        }
+        y[u] = (s0 + s1) + (s2 + s3);
+    }
+}
+
+#ifdef GRAPH_ALGORITHMS_X86
+// eight arcs per step: gather x at the targets, multiply by the weights, accumulate
+__attribute__((target("avx2,fma")))
+inline void spmv_rows_avx2(const CsrGraph &g, const float *x, float *y, uint32_t begin, uint32_t end, bool weighted) {
+    const uint32_t *t = g.targets.data();
+    const float *w = g.weights.data();
+    for (uint32_t u = begin; u < end; ++u) {
+        uint64_t arc = g.offsets[u], last = g.offsets[u + 1];
+        __m256 sum = _mm256_setzero_ps();
+        for (; arc + 8 <= last; arc += 8) {
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t + arc));
+            __m256 values = _mm256_i32gather_ps(x, index, 4);
+            sum = weighted ? _mm256_fmadd_ps(_mm256_loadu_ps(w + arc), values, sum) : _mm256_add_ps(sum, values);
+        }
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+
+        float total = _mm_cvtss_f32(half);
+        for (; arc < last; ++arc) total += (weighted ? w[arc] : 1.0f) * x[t[arc]];
+        y[u] = total;
+    }
+}
+#endif
+
+
+typedef void (*SpmvRows)(const CsrGraph &, const float *, float *, uint32_t, uint32_t, bool);
+
+// picked once per process, like dot_kernel() in text_embedding.h
+inline SpmvRows spmv_kernel(const char **name = nullptr) {
+    static const char *kernelName = "scalar";
+    static SpmvRows kernel = [] {
+#ifdef GRAPH_ALGORITHMS_X86
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            kernelName = "avx2";
+            return &spmv_rows_avx2;
+        }
+#endif
+        return &spmv_rows_scalar;
+    }();
+    if (name) *name = kernelName;
+    return kernel;
+}
+
+
+// y = A x over the whole graph, rows split into blocks across the shared pool
+inline void spmv(const CsrGraph &g, const std::vector<float> &x, std::vector<float> &y, bool weighted) {
+    SpmvRows rows = spmv_kernel();
+    y.resize(g.node_count());
+    parallel_for(shared_pool(), 0, g.node_count(), [&](size_t begin, size_t end) {
+        rows(g, x.data(), y.data(), static_cast<uint32_t>(begin), static_cast<uint32_t>(end), weighted);
+    }, 2048);
+}
+
+
+// PageRank by power iteration: each round every node keeps (1 - damping) / n and passes the
+// rest to its neighbours in proportion to edge weight; nodes without edges spread theirs over
+// everyone. Stops once the scores move less than tolerance in total (L1). Scores sum to 1.
+inline std::vector<float> pagerank(const CsrGraph &g, bool weighted = true, double damping = 0.85,
+                                   double tolerance = 1e-6, int maxIterations = 100, int *iterations = nullptr) {
+    uint32_t n = g.node_count();
+    std::vector<float> rank(n, n ? 1.0f / n : 0.0f), share(n), next(n);
+    std::vector<float> outWeight(n, 0.0f);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) outWeight[u] += weighted ? g.weights[arc] : 1.0f;
+    }
+
+    int round = 0;
+    while (round < maxIterations && n > 0) {
+        ++round;
+        double dangling = 0.0;
+        for (uint32_t u = 0; u < n; ++u) {
+            if (outWeight[u] > 0.0f) share[u] = rank[u] / outWeight[u];
+            else {
+                share[u] = 0.0f;
+                dangling += rank[u];
+            }
+        }
+
+        spmv(g, share, next, weighted);
+
+        float base = static_cast<float>((1.0 - damping + damping * dangling) / n);
+        double change = 0.0;
+        for (uint32_t u = 0; u < n; ++u) {
+            next[u] = base + static_cast<float>(damping) * next[u];
+            change += std::abs(next[u] - rank[u]);
+        }
+        rank.swap(next);
+        if (change < tolerance) break;
+    }
+    if (iterations) *iterations = round;
+    return rank;
+}
+
+
+// Eigenvector centrality: the leading eigenvector of the adjacency matrix by power iteration
+// on A + I (the shift keeps bipartite parts from oscillating), scaled so the top score is 1.
+// Stops once no score moves more than tolerance.
+inline std::vector<float> eigenvector_centrality(const CsrGraph &g, bool weighted = true, double tolerance = 1e-6,
+                                                 int maxIterations = 200, int *iterations = nullptr) {
+    uint32_t n = g.node_count();
+    std::vector<float> score(n, 1.0f), next(n);
+
+    int round = 0;
+    while (round < maxIterations && n > 0) {
+        ++round;
+        spmv(g, score, next, weighted);
+
+        float top = 0.0f;
+        for (uint32_t u = 0; u < n; ++u) {
+            next[u] += score[u];
+            top = std::max(top, next[u]);
+        }
+        if (top == 0.0f) break;
+
+        double change = 0.0;
+        for (uint32_t u = 0; u < n; ++u) {
+            next[u] /= top;
+            change = std::max(change, static_cast<double>(std::abs(next[u] - score[u])));
+        }
+        score.swap(next);
+        if (change < tolerance) break;
+    }
+    if (iterations) *iterations = round;
+    return score;
+}
+
+
+// Personalized PageRank by forward push (Andersen, Chung & Lang). The restart distribution
+// (one source, or several weighted seeds) starts out as residual; any node holding more
+// residual than epsilon times its weighted degree keeps alpha of it as score and pushes the
+// rest to its neighbours by edge weight. Every node's score then undershoots the exact one by
+// at most epsilon * its degree, and the leftover residual bounds the total error. Work is about
+// 1 / (alpha * epsilon) arcs however big the graph is.
+struct PersonalizedRank {
+    std::vector<std::pair<uint32_t, double>> scores;   // nodes that got any score, highest first
+    double residual = 0.0;                             // mass not yet pushed, sum of all errors
+    size_t pushes = 0;
+};
+
+
+// seeds are (node, weight) pairs; weights are scaled to sum to 1
+inline PersonalizedRank personalized_pagerank(const CsrGraph &g, const std::vector<std::pair<uint32_t, double>> &seeds,
+                                              double alpha = 0.15, double epsilon = 1e-6, bool weighted = true) {
+    uint32_t n = g.node_count();
+    PersonalizedRank result;
+    double seedTotal = 0.0;
+    for (const auto &seed : seeds) {
+        if (seed.first >= n || seed.second < 0.0) return result;
+        seedTotal += seed.second;
+    }
+    if (seedTotal <= 0.0) return result;
+
+    thread_local std::vector<double> score, residual, strength;
+    thread_local std::vector<uint8_t> queued;
+    thread_local std::vector<uint32_t> touched;
+    if (score.size() != n) {
+        score.assign(n, 0.0);
+        residual.assign(n, 0.0);
+        strength.assign(n, -1.0);   // weighted degree, filled in on first touch
+        queued.assign(n, 0);
+    }
+    touched.clear();
+
+    auto degree_of = [&](uint32_t u) {
+        if (strength[u] < 0.0) {
+            double d = 0.0;
+            for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) d += weighted ? g.weights[arc] : 1.0;
+            strength[u] = d;
+            touched.push_back(u);
+        }
+        return strength[u];
+    };
+
+    std::queue<uint32_t> active;
+    for (const auto &seed : seeds) {
+        residual[seed.first] += seed.second / seedTotal;
+        degree_of(seed.first);
+        if (!queued[seed.first]) {
+            queued[seed.first] = 1;
+            active.push(seed.first);
+        }
+    }
+
+    while (!active.empty()) {
+        uint32_t u = active.front();
+        active.pop();
+        queued[u] = 0;
+
+        double d = degree_of(u), r = residual[u];
+        if (r <= epsilon * d) continue;
+        ++result.pushes;
+        residual[u] = 0.0;
+        if (d == 0.0) {
+            score[u] += r;   // nowhere to go: every walk here restarts at the seeds, which is this one
+            continue;
+        }
+        score[u] += alpha * r;
+        double share = (1.0 - alpha) * r / d;
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            uint32_t v = g.targets[arc];
+            residual[v] += share * (weighted ? g.weights[arc] : 1.0);
+            if (!queued[v] && residual[v] > epsilon * degree_of(v)) {
+                queued[v] = 1;
+                active.push(v);
+            }
+        }
+    }
+
+    // only touched entries changed, so put those back instead of clearing everything next time
+    for (uint32_t u : touched) {
+        result.residual += residual[u];
+        if (score[u] > 0.0) result.scores.emplace_back(u, score[u]);
+        score[u] = residual[u] = 0.0;
+        strength[u] = -1.0;
+    }
+    std::sort(result.scores.begin(), result.scores.end(), [](const auto &x, const auto &y) {
+        return x.second > y.second || (x.second == y.second && x.first < y.first);
+    });
+    return result;
+}
+
+
+inline PersonalizedRank personalized_pagerank(const CsrGraph &g, uint32_t source, double alpha = 0.15,
+                                              double epsilon = 1e-6, bool weighted = true) {
+    return personalized_pagerank(g, std::vector<std::pair<uint32_t, double>>{{source, 1.0}}, alpha, epsilon, weighted);
+}
+
+// Betweenness centrality: the share of all shortest paths between other people that run
+// through a node. Exact Brandes needs one BFS per node, so sources are sampled instead.
+
+struct Betweenness {
+    std::vector<double> score;   // per node, fraction of ordered pairs' shortest paths through it, 0..1
+    size_t samples = 0;          // sources searched
+    double error = 0.0;          // every score is within this of the exact one, with probability 1 - delta
+    bool exact = false;          // every node was a source, so error is 0
+    bool bound_met = false;      // error <= epsilon; false when the cap or the time budget ran out first
+};
+
+
+// Brandes' dependencies of one source: after the BFS, walks back from the farthest nodes and
+// hands each one's share of paths to the neighbours one hop closer. Predecessors are found by
+// distance instead of being stored. Adds dependency / (n - 1) of every node into sum and its
+// square into sumSquares.
+inline void brandes_source(const CsrGraph &g, uint32_t s, std::vector<double> &sum, std::vector<double> &sumSquares) {
+    uint32_t n = g.node_count();
+    thread_local std::vector<int32_t> distance;
+    thread_local std::vector<double> paths, dependency;
+    thread_local std::vector<uint32_t> order;
+    if (distance.size() < n) {
+        distance.assign(n, -1);
+        paths.assign(n, 0.0);
+        dependency.assign(n, 0.0);
+    }
+
+    order.clear();
+    order.push_back(s);
+    distance[s] = 0;
+    paths[s] = 1.0;
+    for (size_t head = 0; head < order.size(); ++head) {
+        uint32_t u = order[head];
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            uint32_t v = g.targets[arc];
+            if (distance[v] < 0) {
+                distance[v] = distance[u] + 1;
+                order.push_back(v);
+            }
+            if (distance[v] == distance[u] + 1) paths[v] += paths[u];
+        }
+    }
+
+    double scale = 1.0 / (n - 1);
+    for (size_t i = order.size(); i-- > 1;) {
+        uint32_t w = order[i];
+        double share = (1.0 + dependency[w]) / paths[w];
+        for (uint64_t arc = g.offsets[w]; arc < g.offsets[w + 1]; ++arc) {
+            uint32_t v = g.targets[arc];
+            if (distance[v] == distance[w] - 1) dependency[v] += paths[v] * share;
+        }
+        double x = dependency[w] * scale;
+        sum[w] += x;
+        sumSquares[w] += x * x;
+    }
+
+    for (uint32_t u : order) {
+        distance[u] = -1;
+        paths[u] = 0.0;
+        dependency[u] = 0.0;
+    }
+}
+
+
+// Betweenness from randomly chosen sources (Brandes & Pich), searched in parallel on the shared
+// pool. Every sampled source gives each node an unbiased draw in [0, 1] of its score, so after
+// a batch the empirical Bernstein bound (Maurer & Pontil) says how far the mean can be off;
+// batches double until the worst node's bound is under epsilon. The confidence delta is split
+// over the nodes and halved for every check, so all scores hold together. Small or loose graphs
+// simply end with every node searched and an exact answer.
+//
+// The bound's range term alone is 7 log(2n / delta) / 3(r - 1), so a small epsilon needs
+// thousands of sources whatever the graph. Callers that can't wait pass a non-zero maxSamples
+// or budgetSeconds; batches are then trimmed to what is left, error reports the bound actually
+// reached and bound_met says whether it got to epsilon.
+inline Betweenness betweenness_sampled(const CsrGraph &g, double epsilon = 0.01, double delta = 0.1,
+                                       size_t maxSamples = 0, double budgetSeconds = 0.0, uint64_t seed = 42) {
+    uint32_t n = g.node_count();
+    Betweenness result;
+    result.score.assign(n, 0.0);
+    if (n < 3) {
+        result.exact = true;
+        result.bound_met = true;
+        return result;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(); };
+
+    std::vector<uint32_t> sources(n);
+    for (uint32_t u = 0; u < n; ++u) sources[u] = u;
+    std::mt19937_64 rng(seed);
+    std::shuffle(sources.begin(), sources.end(), rng);
+
+    std::vector<double> sum(n, 0.0), sumSquares(n, 0.0);
+    std::mutex merge;
+    size_t batch = std::max<size_t>(64, 8 * shared_pool().size());
+    double checkDelta = delta / 2.0;
+
+    size_t cap = maxSamples ? std::min<size_t>(n, std::max<size_t>(2, maxSamples)) : n;
+    while (result.samples < cap) {
+        size_t end = std::min(cap, result.samples + batch);
+        if (budgetSeconds > 0.0 && result.samples > 0) {
+            // sources cost about the same each, so the next batch gets what the budget still buys
+            double perSource = elapsed() / static_cast<double>(result.samples);
+            double left = budgetSeconds - elapsed();
+            size_t affordable = perSource > 0.0 ? static_cast<size_t>(std::max(1.0, left / perSource)) : batch;
+            end = std::min(end, result.samples + affordable);
+        }
+        parallel_for(shared_pool(), result.samples, end, [&](size_t begin, size_t stop) {
+            std::vector<double> localSum(n, 0.0), localSquares(n, 0.0);
+            for (size_t i = begin; i < stop; ++i) brandes_source(g, sources[i], localSum, localSquares);
+            std::lock_guard<std::mutex> lock(merge);
+            for (uint32_t u = 0; u < n; ++u) {
+                sum[u] += localSum[u];
+                sumSquares[u] += localSquares[u];
+            }
+        }, 1);
+        result.samples = end;
+        batch = end;   // doubles the total each round
+        if (result.samples == n) break;
+
+        double r = static_cast<double>(result.samples);
+        double log = std::log(2.0 * n / checkDelta);
+        double worst = 0.0;
+        for (uint32_t u = 0; u < n; ++u) {
+            double mean = sum[u] / r;
+            double variance = std::max(0.0, (sumSquares[u] - r * mean * mean) / (r - 1.0));
+            worst = std::max(worst, std::sqrt(2.0 * variance * log / r) + 7.0 * log / (3.0 * (r - 1.0)));
+        }
+        result.error = std::min(1.0, worst);   // scores are shares, so 1 is always true
+        if (worst <= epsilon || result.samples == cap) break;
+        if (budgetSeconds > 0.0 && elapsed() >= budgetSeconds) break;
+        checkDelta /= 2.0;
+    }
+
+    result.exact = result.samples == n;
+    if (result.exact) result.error = 0.0;
+    result.bound_met = result.error <= epsilon;
+    for (uint32_t u = 0; u < n; ++u) result.score[u] = sum[u] / static_cast<double>(result.samples);
+    return result;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Triangles
+
+struct Triangles {
+    std::vector<uint64_t> count;      // per node, triangles it is a corner of
+    std::vector<double> clustering;   // per node, count / (degree choose 2); 0 below degree 2
+    uint64_t total = 0;
+    double transitivity = 0.0;        // 3 * total / paths of length two, over the whole graph
+    double average_clustering = 0.0;
+};
+
+
+// Triangles by degree-ordered orientation: every edge points from the lower to the higher of
+// (degree, id), so no node has more than about sqrt(2m) arcs out even inside big cliques, and
+// each triangle u < v < w is met exactly once, at arc u -> v, as a shared out-neighbour w.
+// The sorted lists are intersected with bitset_kernels() (AVX2 block compare, galloping when
+// one side is much longer, or bitset popcounts on dense graphs), rows split over the pool.
+inline Triangles count_triangles(const CsrGraph &g) {
+    uint32_t n = g.node_count();
+    Triangles result;
+    result.count.assign(n, 0);
+    result.clustering.assign(n, 0.0);
+
+    auto lower = [&](uint32_t u, uint32_t v) {
+        return g.degree(u) < g.degree(v) || (g.degree(u) == g.degree(v) && u < v);
+    };
+
+    // split every row into its higher (out) and lower (in) neighbours, both still sorted by id
+    std::vector<uint64_t> outOffsets(n + 1, 0), inOffsets(n + 1, 0);
+    std::vector<uint8_t> outward(g.arc_count());
+    for (uint32_t u = 0; u < n; ++u) {
+        uint64_t out = 0;
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            outward[arc] = lower(u, g.targets[arc]);
+            out += outward[arc];
+        }
+        outOffsets[u + 1] = outOffsets[u] + out;
+        inOffsets[u + 1] = inOffsets[u] + g.degree(u) - out;
+    }
+    std::vector<uint32_t> outTargets(outOffsets[n]), inTargets(inOffsets[n]);
+    for (uint32_t u = 0; u < n; ++u) {
+        uint64_t out = outOffsets[u], in = inOffsets[u];
+        for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+            if (outward[arc]) outTargets[out++] = g.targets[arc];
+            else inTargets[in++] = g.targets[arc];
+        }
+    }
+
+    const BitsetKernels &kernels = bitset_kernels();
+
+    // for every arc u -> v: |out(u) & out(v)| triangles have u lowest and v in the middle, and
+    // |out(u) & in(v)| have u lowest and v highest. Both intersections are bounded by the short
+    // out-list (galloping through a long in-list), and u's own count is the first summed.
+    // When rows average more ids than a bitset over all nodes has words (dense group layers),
+    // the lists are turned into bitsets and intersected with and_popcount instead.
+    size_t words = (static_cast<size_t>(n) + 63) / 64;
+    bool dense = static_cast<uint64_t>(n) * words <= (uint64_t(1) << 22) && g.arc_count() >= uint64_t(n) * words;
+    std::vector<uint64_t> outBits, inBits;
+    if (dense) {
+        outBits.assign(static_cast<size_t>(n) * words, 0);
+        inBits.assign(static_cast<size_t>(n) * words, 0);
+        for (uint32_t u = 0; u < n; ++u) {
+            for (uint64_t i = outOffsets[u]; i < outOffsets[u + 1]; ++i) {
+                outBits[u * words + (outTargets[i] >> 6)] |= uint64_t(1) << (outTargets[i] & 63);
+            }
+            for (uint64_t i = inOffsets[u]; i < inOffsets[u + 1]; ++i) {
+                inBits[u * words + (inTargets[i] >> 6)] |= uint64_t(1) << (inTargets[i] & 63);
+            }
+        }
+    }
+
+    std::vector<std::atomic<uint64_t>> credited(n);
+    for (auto &c : credited) c.store(0, std::memory_order_relaxed);
+    parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+        for (size_t u = begin; u < end; ++u) {
+            const uint32_t *out = outTargets.data() + outOffsets[u];
+            size_t outSize = outOffsets[u + 1] - outOffsets[u];
+            uint64_t lowest = 0;
+            for (size_t i = 0; i < outSize; ++i) {
+                uint32_t v = out[i];
+                uint64_t middle, highest;
+                if (dense) {
+                    middle = kernels.and_popcount(&outBits[u * words], &outBits[v * words], words);
+                    highest = kernels.and_popcount(&outBits[u * words], &inBits[v * words], words);
+                } else {
+                    middle = kernels.intersect_count(out, outSize, outTargets.data() + outOffsets[v],
+                                                     outOffsets[v + 1] - outOffsets[v]);
+                    highest = kernels.intersect_count(out, outSize, inTargets.data() + inOffsets[v],
+                                                      inOffsets[v + 1] - inOffsets[v]);
+                }
+                lowest += middle;
+                if (middle + highest) credited[v].fetch_add(middle + highest, std::memory_order_relaxed);
+            }
+            result.count[u] = lowest;
+        }
+    }, 64);
+
+    double wedges = 0.0, clusteringSum = 0.0;
+    uint64_t corners = 0;
+    for (uint32_t u = 0; u < n; ++u) {
+        result.count[u] += credited[u].load(std::memory_order_relaxed);
+        corners += result.count[u];
+        double d = g.degree(u);
+        double pairs = d * (d - 1.0) / 2.0;
+        wedges += pairs;
+        if (pairs > 0.0) result.clustering[u] = static_cast<double>(result.count[u]) / pairs;
+        clusteringSum += result.clustering[u];
+    }
+    result.total = corners / 3;
+    if (wedges > 0.0) result.transitivity = 3.0 * static_cast<double>(result.total) / wedges;
+    if (n > 0) result.average_clustering = clusteringSum / n;
+    return result;
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Link prediction
+
+// How likely two unlinked people are to know each other, from the neighbours they share:
+// common neighbours counts them, Adamic-Adar weighs each by 1 / log(degree) and resource
+// allocation by 1 / degree, so a shared small circle says more than a shared hub.
+enum class LinkScore { COMMON_NEIGHBOURS, ADAMIC_ADAR, RESOURCE_ALLOCATION };
+
+struct LinkPrediction {
+    uint32_t a;
+    uint32_t b;
+    double score;
+    uint32_t common;   // shared neighbours
+};
+
+
+inline double link_weight(const CsrGraph &g, uint32_t w, LinkScore kind) {
+    double d = g.degree(w);
+    switch (kind) {
+        case LinkScore::COMMON_NEIGHBOURS:   return 1.0;
+        case LinkScore::ADAMIC_ADAR:         return d > 1.0 ? 1.0 / std::log(d) : 0.0;
+        case LinkScore::RESOURCE_ALLOCATION: return d > 0.0 ? 1.0 / d : 0.0;
+    }
+    return 0.0;
+}
+
+
+// Scores a given list of pairs, spread over the shared pool. Common neighbours is just the
+// intersection size (bitset_kernels().intersect_count); the weighted scores need the shared
+// ids themselves. Linked pairs are scored all the same.
+inline std::vector<LinkPrediction> score_links(const CsrGraph &g, const std::vector<std::pair<uint32_t, uint32_t>> &pairs,
+                                               LinkScore kind) {
+    std::vector<LinkPrediction> out(pairs.size());
+    const BitsetKernels &kernels = bitset_kernels();
+    uint32_t n = g.node_count();
+    parallel_for(shared_pool(), 0, pairs.size(), [&](size_t begin, size_t end) {
+        std::vector<uint32_t> shared;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t a = pairs[i].first, b = pairs[i].second;
+            out[i] = {a, b, 0.0, 0};
+            if (a >= n || b >= n || a == b) continue;
+
+            const uint32_t *na = g.targets.data() + g.offsets[a], *nb = g.targets.data() + g.offsets[b];
+            if (kind == LinkScore::COMMON_NEIGHBOURS) {
+                out[i].common = static_cast<uint32_t>(kernels.intersect_count(na, g.degree(a), nb, g.degree(b)));
+                out[i].score = out[i].common;
+                continue;
+            }
+            shared.resize(std::min(g.degree(a), g.degree(b)));
+            out[i].common = static_cast<uint32_t>(intersect_sorted(na, g.degree(a), nb, g.degree(b), shared.data()));
+            for (uint32_t j = 0; j < out[i].common; ++j) out[i].score += link_weight(g, shared[j], kind);
+        }
+    }, 256);
+    return out;
+}
+
+
+// The k best unlinked partners of every node in `nodes` (all of them when empty), best first.
+// Each node walks its neighbours' neighbours into a dense score array, so only pairs with at
+// least one neighbour in common are ever touched, never all n^2. Rows run on the shared pool.
+inline std::vector<std::vector<LinkPrediction>> predict_links(const CsrGraph &g, size_t k, LinkScore kind,
+                                                              const std::vector<uint32_t> &nodes = {}) {
+    uint32_t n = g.node_count();
+    std::vector<uint32_t> rows = nodes;
+    if (rows.empty()) {
+        rows.resize(n);
+        for (uint32_t u = 0; u < n; ++u) rows[u] = u;
+    }
+
+    std::vector<double> weight(n);
+    for (uint32_t w = 0; w < n; ++w) weight[w] = link_weight(g, w, kind);
+
+    std::vector<std::vector<LinkPrediction>> out(rows.size());
+    parallel_for(shared_pool(), 0, rows.size(), [&](size_t begin, size_t end) {
+        std::vector<double> score(n, 0.0);
+        std::vector<uint32_t> common(n, 0), touched;
+        for (size_t r = begin; r < end; ++r) {
+            uint32_t u = rows[r];
+            if (u >= n) continue;
+            uint64_t wedges = 0;
+            for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) wedges += g.degree(g.targets[arc]);
+
+            // when the walk will reach most of the graph anyway, skip the touched bookkeeping in
+            // the inner loop and sweep the whole row afterwards
+            bool sweep = wedges > n;
+            for (uint64_t arc = g.offsets[u]; arc < g.offsets[u + 1]; ++arc) {
+                uint32_t w = g.targets[arc];
+                double f = weight[w];
+                const uint32_t *next = g.targets.data() + g.offsets[w], *stop = g.targets.data() + g.offsets[w + 1];
+                if (sweep) {
+                    for (; next != stop; ++next) {
+                        score[*next] += f;
+                        ++common[*next];
+                    }
+                } else {
+                    for (; next != stop; ++next) {
+                        if (common[*next]++ == 0) touched.push_back(*next);
+                        score[*next] += f;
+                    }
+                }
+            }
+            if (sweep) {
+                for (uint32_t v = 0; v < n; ++v) {
+                    if (common[v]) touched.push_back(v);
+                }
+            }
+            score[u] = 0.0;   // every neighbour leads straight back to u
+            common[u] = 0;
+
+            // neighbours are already linked: u's row is sorted, so drop them by binary search
+            auto first = g.targets.begin() + g.offsets[u], last = g.targets.begin() + g.offsets[u + 1];
+            auto &best = out[r];
+            for (uint32_t v : touched) {
+                if (v != u && !std::binary_search(first, last, v)) best.push_back({u, v, score[v], common[v]});
+                score[v] = 0.0;
+                common[v] = 0;
+            }
+            touched.clear();
+
+            auto better = [](const LinkPrediction &x, const LinkPrediction &y) {
+                return x.score > y.score || (x.score == y.score && x.b < y.b);
+            };
+            if (best.size() > k) {
+                std::partial_sort(best.begin(), best.begin() + k, best.end(), better);
+                best.resize(k);
+            } else {
+                std::sort(best.begin(), best.end(), better);
+            }
+        }
+    }, 16);
+    return out;
+}
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef HNSW_INDEX_H
+#define HNSW_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "text_embedding.h"
+
+// Hierarchical navigable small world graph over unit-length vectors (Malkov & Yashunin).
+//
+// Every vector is a node on layer 0; each node also appears on the layers above it with
+// probability 1/M per layer. A search greedily walks down from the sparse top layer and then
+// does a best-first search with `ef` candidates on layer 0, so a query touches a few hundred
+// nodes instead of all of them.
+//
+// Nodes are keyed by a caller label (the contact id). Removing a label only marks its node:
+// it keeps routing searches but is never returned, and inserting the label again adds a fresh
+// node. compact() rebuilds without the dead nodes once they pile up.
+
+class HnswIndex {
+public:
+    explicit HnswIndex(int dim = EMBEDDING_DIM, int m = 16, int efConstruction = 100)
+        : dim_(dim), m_(m), efConstruction_(efConstruction), levelScale_(1.0 / std::log(static_cast<double>(m))) {}
+
+    int dim() const { return dim_; }
+    size_t size() const { return byLabel_.size(); }          // live labels
+    size_t node_count() const { return nodes_.size(); }       // including removed ones
+
+    bool contains(uint32_t label) const { return byLabel_.count(label) > 0; }
+
+    const float *vector_of(uint32_t label) const {
+        auto it = byLabel_.find(label);
+        return it == byLabel_.end() ? nullptr : vector_at(it->second);
+    }
+
+    // adds a label, or replaces its vector if it is already present
+    void insert(uint32_t label, const float *vector) {
+        remove(label);
+
+        uint32_t node = static_cast<uint32_t>(nodes_.size());
+        int level = random_level();
+        nodes_.push_back({label, level, false, std::vector<std::vector<uint32_t>>(level + 1)});
+        vectors_.insert(vectors_.end(), vector, vector + dim_);
+        byLabel_[label] = node;
+
+        if (entry_ < 0) {
+            entry_ = static_cast<int>(node);
+            maxLevel_ = level;
+            return;
+        }
+
+        uint32_t current = static_cast<uint32_t>(entry_);
+        float currentDistance = distance(vector, current);
+        for (int layer = maxLevel_; layer > level; --layer) {
+            greedy_step(vector, layer, current, currentDistance);
+        }
+
+        for (int layer = std::min(level, maxLevel_); layer >= 0; --layer) {
+            std::vector<Candidate> found = search_layer(vector, current, efConstruction_, layer);
+            std::vector<uint32_t> neighbours = select_neighbours(found, m_);
+            nodes_[node].links[layer] = neighbours;
+
+            for (uint32_t other : neighbours) {
+                auto &links = nodes_[other].links[layer];
+                links.push_back(node);
+                if (links.size() > max_links(layer)) prune(other, layer);
+            }
+            current = found.front().node;
+        }
+
+        if (level > maxLevel_) {
+            maxLevel_ = level;
+            entry_ = static_cast<int>(node);
+        }
+    }
+
+    bool remove(uint32_t label) {
+        auto it = byLabel_.find(label);
+        if (it == byLabel_.end()) return false;
+        nodes_[it->second].deleted = true;
+        byLabel_.erase(it);
+        return true;
+    }
+
+    // k live labels nearest to query with their cosine similarity, best first
+    std::vector<std::pair<uint32_t, float>> search(const float *query, size_t k, size_t ef = 64) const {
+        std::vector<std::pair<uint32_t, float>> results;
+        if (entry_ < 0 || k == 0) return results;
+
+        uint32_t current = static_cast<uint32_t>(entry_);
+        float currentDistance = distance(query, current);
+        for (int layer = maxLevel_; layer > 0; --layer) {
+            greedy_step(query, layer, current, currentDistance);
+        }
+
+        // removed nodes take up candidate slots, so widen the beam by how many there are
+        size_t dead = nodes_.size() - byLabel_.size();
+        size_t beam = std::max(ef, k) + std::min(dead, std::max(ef, k));
+        for (const Candidate &c : search_layer(query, current, beam, 0)) {
+            if (nodes_[c.node].deleted) continue;
+            results.emplace_back(nodes_[c.node].label, 1.0f - c.distance);
+            if (results.size() == k) break;
+        }
+        return results;
+    }
+
+    // rebuilds the graph from the live nodes only
+    void compact() {
+        HnswIndex fresh(dim_, m_, efConstruction_);
+        for (const Node &n : nodes_) {
+            if (!n.deleted) fresh.insert(n.label, vector_at(static_cast<uint32_t>(&n - nodes_.data())));
+        }
+        *this = std::move(fresh);
+    }
+
+    bool save(const std::string &path) const {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Cannot write " << path << std::endl;
+            return false;
+        }
+
+        bool ok = write(file, MAGIC) && write(file, dim_) && write(file, m_) && write(file, efConstruction_) &&
+                  write(file, maxLevel_) && write(file, entry_) && write(file, static_cast<uint32_t>(nodes_.size()));
+        for (size_t i = 0; ok && i < nodes_.size(); ++i) {
+            const Node &n = nodes_[i];
+            ok = write(file, n.label) && write(file, n.level) && write(file, static_cast<uint8_t>(n.deleted)) &&
+                 std::fwrite(vector_at(static_cast<uint32_t>(i)), sizeof(float), dim_, file) == static_cast<size_t>(dim_);
+            for (int layer = 0; ok && layer <= n.level; ++layer) {
+                const auto &links = n.links[layer];
+                ok = write(file, static_cast<uint32_t>(links.size())) &&
+                     std::fwrite(links.data(), sizeof(uint32_t), links.size(), file) == links.size();
+            }
+        }
+
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) std::cerr << "Failed writing " << path << std::endl;
+        return ok;
+    }
+
+    // false if the file is missing or not an index; the index is left empty then
+    bool load(const std::string &path) {
+        *this = HnswIndex(dim_, m_, efConstruction_);
+
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+
+        uint32_t magic = 0, count = 0;
+        bool ok = read(file, magic) && magic == MAGIC && read(file, dim_) && read(file, m_) &&
+                  read(file, efConstruction_) && read(file, maxLevel_) && read(file, entry_) && read(file, count) &&
+                  dim_ > 0 && m_ > 1;
+        if (ok) levelScale_ = 1.0 / std::log(static_cast<double>(m_));
+
+        for (uint32_t i = 0; ok && i < count; ++i) {
+            Node n;
+            uint8_t deleted = 0;
+            ok = read(file, n.label) && read(file, n.level) && read(file, deleted) && n.level >= 0 && n.level < 64;
+            if (!ok) break;
+            n.deleted = deleted != 0;
+
+            size_t offset = vectors_.size();
+            vectors_.resize(offset + dim_);
+            ok = std::fread(vectors_.data() + offset, sizeof(float), dim_, file) == static_cast<size_t>(dim_);
+
+            n.links.resize(n.level + 1);
+            for (int layer = 0; ok && layer <= n.level; ++layer) {
+                uint32_t links = 0;
+                ok = read(file, links) && links <= count;
+                if (!ok) break;
+                n.links[layer].resize(links);
+                ok = std::fread(n.links[layer].data(), sizeof(uint32_t), links, file) == links;
+                for (uint32_t other : n.links[layer]) ok = ok && other < count;
+            }
+
+            if (ok && !n.deleted) byLabel_[n.label] = i;
+            nodes_.push_back(std::move(n));
+        }
+        std::fclose(file);
+
+        ok = ok && entry_ < static_cast<int>(nodes_.size());
+        if (!ok) {
+            std::cerr << path << " is not a valid index, ignoring it" << std::endl;
+            *this = HnswIndex(dim_, m_, efConstruction_);
+        }
+        return ok;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x57534e48;  // "HNSW"
+
+    struct Node {
+        uint32_t label;
+        int level;
+        bool deleted;
+        std::vector<std::vector<uint32_t>> links;  // per layer, up to max_links(layer)
+    };
+
+    struct Candidate {
+        float distance;
+        uint32_t node;
+        bool operator<(const Candidate &other) const { return distance < other.distance; }
+        bool operator>(const Candidate &other) const { return distance > other.distance; }
+    };
+
+    template <typename T>
+    static bool write(FILE *file, const T &value) { return std::fwrite(&value, sizeof(T), 1, file) == 1; }
+
+    template <typename T>
+    static bool read(FILE *file, T &value) { return std::fread(&value, sizeof(T), 1, file) == 1; }
+
+    const float *vector_at(uint32_t node) const { return vectors_.data() + static_cast<size_t>(node) * dim_; }
+
+    float distance(const float *query, uint32_t node) const {
+        return 1.0f - dot_kernel()(query, vector_at(node), dim_);
+    }
+
+    size_t max_links(int layer) const { return layer == 0 ? 2 * m_ : m_; }
+
+    int random_level() {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        double r = uniform(rng_);
+        return static_cast<int>(-std::log(std::max(r, 1e-12)) * levelScale_);
+    }
+
+    // moves to the closest neighbour on this layer until nothing is closer
+    void greedy_step(const float *query, int layer, uint32_t &current, float &currentDistance) const {
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (uint32_t other : nodes_[current].links[layer]) {
+                float d = distance(query, other);
+                if (d < currentDistance) {
+                    currentDistance = d;
+                    current = other;
+                    moved = true;
+                }
+            }
+        }
+    }
+
+    // best-first search keeping the ef closest nodes seen; returned nearest first
+    std::vector<Candidate> search_layer(const float *query, uint32_t start, size_t ef, int layer) const {
+        // per-thread marks stamped with a fresh epoch, so nothing is cleared between searches
+        thread_local std::vector<uint32_t> visited;
+        thread_local uint32_t epoch = 0;
+        if (visited.size() < nodes_.size()) visited.resize(nodes_.size(), 0);
+        if (++epoch == 0) {
+            std::fill(visited.begin(), visited.end(), 0);
+            epoch = 1;
+        }
+
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+        std::priority_queue<Candidate> best;
+
+        Candidate first{distance(query, start), start};
+        frontier.push(first);
+        best.push(first);
+        visited[start] = epoch;
+
+        while (!frontier.empty()) {
+            Candidate c = frontier.top();
+            if (c.distance > best.top().distance && best.size() >= ef) break;
+            frontier.pop();
+
+            for (uint32_t other : nodes_[c.node].links[layer]) {
+                if (visited[other] == epoch) continue;
+                visited[other] = epoch;
+
+                float d = distance(query, other);
+                if (best.size() < ef || d < best.top().distance) {
+                    frontier.push({d, other});
+                    best.push({d, other});
+                    if (best.size() > ef) best.pop();
+                }
+            }
+        }
+
+        std::vector<Candidate> out(best.size());
+        for (size_t i = out.size(); i-- > 0;) {
+            out[i] = best.top();
+            best.pop();
+        }
+        return out;
+    }
+
+    // the paper's heuristic: keep a candidate only if it is closer to the new node than to any
+    // neighbour already kept, which spreads links in different directions
+    std::vector<uint32_t> select_neighbours(const std::vector<Candidate> &sorted, size_t count) const {
+        std::vector<uint32_t> kept;
+        for (const Candidate &c : sorted) {
+            if (kept.size() >= count) break;
+            bool diverse = true;
+            for (uint32_t k : kept) {
+                if (distance(vector_at(c.node), k) < c.distance) {
+                    diverse = false;
+                    break;
+                }
+            }
+            if (diverse) kept.push_back(c.node);
+        }
+        return kept;
+    }
+
+    void prune(uint32_t node, int layer) {
+        std::vector<Candidate> candidates;
+        for (uint32_t other : nodes_[node].links[layer]) {
+            candidates.push_back({distance(vector_at(node), other), other});
+        }
+        std::sort(candidates.begin(), candidates.end());
+        nodes_[node].links[layer] = select_neighbours(candidates, max_links(layer));
+    }
+
+    int dim_;
+    int m_;
+    int efConstruction_;
+    double levelScale_;
+    int maxLevel_ = 0;
+    int entry_ = -1;
+    std::vector<Node> nodes_;
+    std::vector<float> vectors_;                        // node-major, dim_ floats each
+    std::unordered_map<uint32_t, uint32_t> byLabel_;    // live label -> node
+    std::mt19937_64 rng_{42};
+};
+
+#endif
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <sqlite3.h>
+#include "term_dictionary.h"
+#include "entity_resolution.h"
 
 struct Contact {
     std::string name, email, phone, location;
@@ -63,16 +65,61 @@ std::vector<Contact> read_contacts(const std::string& filename) {
     return contacts;
 }
 
-void insert_contacts_to_db(const std::vector<Contact>& contacts, const std::string& db_path) {
+// Rewrites each item of a comma separated field that synonyms.txt knows to its canonical name,
+// so "Maths, Weightlifting" is stored as "math, strength training"; other items stay as typed.
+std::string canonical_list(const TermDictionary& dictionary, const std::string& field) {
+    std::string joined;
+    std::stringstream ss(field);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::string canonical = dictionary.canonical_item(item);
+        if (canonical.empty()) continue;
+        if (!joined.empty()) joined += ", ";
+        joined += canonical;
+    }
+    return joined;
+}
+
+// runs one statement that needs no bindings; false (and the error printed) if it fails
+bool exec(sqlite3* db, const char* sql) {
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+        std::cerr << "SQL error: " << errorMessage << std::endl;
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    return true;
+}
+
+// Inserts every contact in one transaction; nothing is written if any statement fails.
+bool insert_contacts_to_db(const std::vector<Contact>& contacts, const std::string& db_path) {
     sqlite3* db;
     if (sqlite3_open(db_path.c_str(), &db)) {
         std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return;
+        sqlite3_close(db);
+        return false;
+    }
+
+    if (!exec(db, "BEGIN IMMEDIATE;")) {
+        sqlite3_close(db);
+        return false;
     }
 
-    for (const auto& c : contacts) {
+    // company and school columns keep what was typed; contact_organizations links them to the
+    // canonical organization
+    EntityResolver companies("company"), schools("school");
+    bool ok = companies.load(db) && schools.load(db);
+    std::vector<sqlite3_int64> contact_ids;
+
+    for (const Contact& c : contacts) {
+        if (!ok) break;
         sqlite3_stmt* stmt;
 
+        companies.resolve_list(c.current_company);
+        companies.resolve_list(c.previous_companies);
+        schools.resolve_list(c.college);
+        schools.resolve_list(c.high_school);
+
         // Insert into contacts
         std::string sql_contacts = "INSERT INTO contacts (name, email, phone, location) VALUES (?, ?, ?, ?);";
         sqlite3_prepare_v2(db, sql_contacts.c_str(), -1, &stmt, nullptr);
@@ -80,10 +127,11 @@ void insert_contacts_to_db(const std::vector<Contact>& contacts, const std::stri
         sqlite3_bind_text(stmt, 2, c.email.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, c.phone.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, c.location.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
         sqlite3_finalize(stmt);
 
         int contact_id = (int)sqlite3_last_insert_rowid(db);
+        contact_ids.push_back(contact_id);
 
         // Insert into employment
         std::string sql_emp = "INSERT INTO employment (contact_id, current_company, previous_companies, industry, job_title) VALUES (?, ?, ?, ?, ?);";
@@ -93,7 +141,7 @@ void insert_contacts_to_db(const std::vector<Contact>& contacts, const std::stri
         sqlite3_bind_text(stmt, 3, c.previous_companies.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, c.industry.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 5, c.job_title.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+        ok = ok && sqlite3_step(stmt) == SQLITE_DONE;
         sqlite3_finalize(stmt);
 
         // Insert into relationships
@@ -103,7 +151,7 @@ void insert_contacts_to_db(const std::vector<Contact>& contacts, const std::stri
         sqlite3_bind_text(stmt, 2, c.relationship_type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, c.closeness.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, c.reliability.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+        ok = ok && sqlite3_step(stmt) == SQLITE_DONE;
         sqlite3_finalize(stmt);
 
         // Insert into background
@@ -113,7 +161,7 @@ void insert_contacts_to_db(const std::vector<Contact>& contacts, const std::stri
         sqlite3_bind_text(stmt, 2, c.interests.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, c.college.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, c.high_school.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+        ok = ok && sqlite3_step(stmt) == SQLITE_DONE;
         sqlite3_finalize(stmt);
 
         // Insert into profile
@@ -123,11 +171,39 @@ void insert_contacts_to_db(const std::vector<Contact>& contacts, const std::stri
         sqlite3_bind_text(stmt, 2, c.career_goals.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, c.skills.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, c.talent_rating.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+        ok = ok && sqlite3_step(stmt) == SQLITE_DONE;
         sqlite3_finalize(stmt);
+
+        if (!ok) std::cerr << "Insert failed for " << c.name << ": " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    // new organizations get their ids here, so the links go in after
+    ok = ok && companies.save(db) && schools.save(db);
+
+    sqlite3_stmt* link = nullptr;
+    if (ok && sqlite3_prepare_v2(db, CONTACT_ORGANIZATION_INSERT, -1, &link, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        ok = false;
+    }
+    for (size_t i = 0; ok && i < contacts.size(); ++i) {
+        const Contact& c = contacts[i];
+        ok = companies.link(link, contact_ids[i], "current_company", c.current_company) &&
+             companies.link(link, contact_ids[i], "previous_companies", c.previous_companies) &&
+             schools.link(link, contact_ids[i], "college", c.college) &&
+             schools.link(link, contact_ids[i], "high_school", c.high_school);
     }
+    sqlite3_finalize(link);
 
+    if (!ok) {
+        exec(db, "ROLLBACK;");
+        sqlite3_close(db);
+        std::cerr << "Import failed, nothing was written." << std::endl;
+        return false;
+    }
+
+    ok = exec(db, "COMMIT;");
     sqlite3_close(db);
+    return ok;
 }
 
 std::ostream& operator<<(std::ostream& os, const Contact& c) {
@@ -155,6 +231,14 @@ std::ostream& operator<<(std::ostream& os, const Contact& c) {
 
 int main() {
     auto contacts = read_contacts("test.txt");
+
+    TermDictionary dictionary;
+    if (dictionary.load("synonyms.txt")) {
+        for (Contact& c : contacts) {
+            c.skills = canonical_list(dictionary, c.skills);
+            c.interests = canonical_list(dictionary, c.interests);
+        }
+    }
     
     /* testing */
 
@@ -164,7 +248,7 @@ int main() {
 
     printf("%d\n", contacts.size());
 
-    insert_contacts_to_db(contacts, "my_database.db");
+    if (!insert_contacts_to_db(contacts, "my_database.db")) return 1;
     std::cout << "✅ Contacts imported into database." << std::endl;
     return 0;
 }
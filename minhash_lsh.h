@@ -0,0 +1,119 @@
+#ifndef MINHASH_LSH_H
+#define MINHASH_LSH_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// MinHash signatures and banded LSH keys for term sets.
+//
+// Two sets agree on one signature slot with probability equal to their Jaccard similarity.
+// Slots are grouped into `bands` bands of `rows` slots, and two sets become candidates when
+// any whole band matches: probability 1 - (1 - J^rows)^bands. That S-curve is steepest around
+// (1 / bands)^(1 / rows), the target similarity. More bands raise recall; more slots in total
+// cost more hashing but sharpen the cut.
+
+struct LshParams {
+    int bands = 16;
+    int rows = 4;
+
+    int hashes() const { return bands * rows; }
+
+    // similarity where a pair has about even odds of becoming a candidate
+    double threshold() const { return std::pow(1.0 / bands, 1.0 / rows); }
+};
+
+
+// Spreads `hashes` slots over the band/row split whose threshold lands closest to `target`.
+inline LshParams lsh_params_for(double target, int hashes) {
+    LshParams best;
+    double bestError = 1e9;
+
+    for (int rows = 1; rows <= hashes; ++rows) {
+        if (hashes % rows != 0) continue;
+        LshParams p;
+        p.rows = rows;
+        p.bands = hashes / rows;
+        double error = std::fabs(p.threshold() - target);
+        if (error < bestError) {
+            bestError = error;
+            best = p;
+        }
+    }
+    return best;
+}
+
+
+// FNV-1a, so signatures depend on the term text and stay valid across runs
+inline uint64_t hash_term(const std::string &term) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : term) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+
+// One slot per hash function; slot i keeps the smallest mix64(term ^ seed_i) over the set.
+// An empty set gets all-max slots and never matches anything.
+inline std::vector<uint32_t> minhash_signature(const std::vector<uint64_t> &termHashes, int hashes) {
+    std::vector<uint32_t> signature(hashes, UINT32_MAX);
+
+    for (uint64_t term : termHashes) {
+        for (int i = 0; i < hashes; ++i) {
+            uint32_t h = static_cast<uint32_t>(mix64(term ^ (0x9e3779b97f4a7c15ull * (i + 1))) >> 32);
+            if (h < signature[i]) signature[i] = h;
+        }
+    }
+    return signature;
+}
+
+
+inline std::vector<uint32_t> minhash_signature(const std::vector<std::string> &terms, int hashes) {
+    std::vector<uint64_t> termHashes;
+    termHashes.reserve(terms.size());
+    for (const auto &term : terms) termHashes.push_back(hash_term(term));
+    return minhash_signature(termHashes, hashes);
+}
+
+
+inline bool empty_signature(const std::vector<uint32_t> &signature) {
+    for (uint32_t slot : signature) {
+        if (slot != UINT32_MAX) return false;
+    }
+    return true;
+}
+
+
+// bucket key of one band; the band number is mixed in so equal rows in different bands don't collide
+inline uint64_t band_key(const std::vector<uint32_t> &signature, const LshParams &params, int band) {
+    uint64_t h = mix64(static_cast<uint64_t>(band) + 1);
+    for (int r = 0; r < params.rows; ++r) {
+        h = mix64(h ^ signature[band * params.rows + r]);
+    }
+    // SQLite integers are signed; keep keys positive so they round-trip through the bucket table
+    return h >> 1;
+}
+
+
+// fraction of agreeing slots, an unbiased estimate of Jaccard similarity
+inline double estimated_jaccard(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) {
+    if (a.empty() || a.size() != b.size()) return 0.0;
+    size_t same = 0;
+    for (size_t i = 0; i < a.size(); ++i) same += a[i] == b[i];
+    return static_cast<double>(same) / a.size();
+}
+
+#endif
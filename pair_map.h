@@ -0,0 +1,166 @@
+#ifndef PAIR_MAP_H
+#define PAIR_MAP_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+
+// An undirected pair of interned ids packed as (min << 32) | max, so (a, b) and (b, a) land on the same key.
+inline uint64_t pair_key(uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+inline uint32_t pair_first(uint64_t key) { return static_cast<uint32_t>(key >> 32); }
+inline uint32_t pair_second(uint64_t key) { return static_cast<uint32_t>(key & 0xffffffffu); }
+
+
+// Hands out dense ids for names and labels so pairs can be keyed by two integers.
+struct Interner {
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+
+    uint32_t intern(const std::string &name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+
+        uint32_t id = static_cast<uint32_t>(names.size());
+        ids.emplace(name, id);
+        names.push_back(name);
+        return id;
+    }
+
+    size_t size() const { return names.size(); }
+};
+
+
+// Label ids attached to one pair. Most pairs share one or two things, so the first few
+// live inline and only busy pairs spill into the heap.
+struct EdgeLabels {
+    static const int INLINE_LABELS = 4;
+
+    uint32_t inlineIds[INLINE_LABELS];
+    uint32_t count = 0;
+    std::vector<uint32_t> overflow;
+
+    // returns false if the label was already there
+    bool add(uint32_t id) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (at(i) == id) return false;
+        }
+        if (count < INLINE_LABELS) {
+            inlineIds[count] = id;
+        } else {
+            overflow.push_back(id);
+        }
+        ++count;
+        return true;
+    }
+
+    uint32_t at(uint32_t i) const {
+        return i < INLINE_LABELS ? inlineIds[i] : overflow[i - INLINE_LABELS];
+    }
+
+    uint32_t size() const { return count; }
+};
+
+
+// Open-addressing hash map from pair_key() to V with linear probing. Keys and values sit in
+// flat arrays, so a pass over all pairs is a straight scan instead of a walk over nodes.
+template <typename V>
+class PairMap {
+public:
+    explicit PairMap(size_t expected = 16) {
+        size_t capacity = 16;
+        while (capacity * 7 < expected * 10) capacity <<= 1;
+        keys_.assign(capacity, EMPTY);
+        values_.resize(capacity);
+    }
+
+    V &operator[](uint64_t key) {
+        if ((size_ + 1) * 10 > keys_.size() * 7) grow();
+
+        size_t slot = find_slot(key);
+        if (keys_[slot] == EMPTY) {
+            keys_[slot] = key;
+            ++size_;
+        }
+        return values_[slot];
+    }
+
+    V *find(uint64_t key) {
+        size_t slot = find_slot(key);
+        return keys_[slot] == EMPTY ? nullptr : &values_[slot];
+    }
+
+    const V *find(uint64_t key) const {
+        size_t slot = find_slot(key);
+        return keys_[slot] == EMPTY ? nullptr : &values_[slot];
+    }
+
+    size_t size() const { return size_; }
+
+    // calls fn(key, value) for every stored pair, in slot order
+    template <typename Fn>
+    void for_each(Fn fn) const {
+        for (size_t i = 0; i < keys_.size(); ++i) {
+            if (keys_[i] != EMPTY) fn(keys_[i], values_[i]);
+        }
+    }
+
+    // the stored keys, sorted, for output that shouldn't depend on hash order
+    std::vector<uint64_t> sorted_keys() const {
+        std::vector<uint64_t> keys;
+        keys.reserve(size_);
+        for (uint64_t k : keys_) {
+            if (k != EMPTY) keys.push_back(k);
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+private:
+    // (max, max) is never a valid pair since a pair needs two distinct ids
+    static constexpr uint64_t EMPTY = ~0ull;
+
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    size_t find_slot(uint64_t key) const {
+        size_t mask = keys_.size() - 1;
+        size_t slot = hash(key) & mask;
+        while (keys_[slot] != EMPTY && keys_[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void grow() {
+        std::vector<uint64_t> oldKeys(keys_.size() * 2, EMPTY);
+        std::vector<V> oldValues(keys_.size() * 2);
+        oldKeys.swap(keys_);
+        oldValues.swap(values_);
+
+        for (size_t i = 0; i < oldKeys.size(); ++i) {
+            if (oldKeys[i] == EMPTY) continue;
+            size_t slot = find_slot(oldKeys[i]);
+            keys_[slot] = oldKeys[i];
+            values_[slot] = std::move(oldValues[i]);
+        }
+    }
+
+    std::vector<uint64_t> keys_;
+    std::vector<V> values_;
+    size_t size_ = 0;
+};
+
+#endif
@@ -0,0 +1,1466 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <unordered_map>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include "sqlite3.h"
+#include "pair_map.h"
+#include "text_normalize.h"
+#include "thread_pool.h"
+#include "minhash_lsh.h"
+#include "term_dictionary.h"
+#include "text_embedding.h"
+#include "hnsw_index.h"
+#include "bitset_kernels.h"
+#include "cli_options.h"
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Native replacement for the pairwise LLM comparisons in sharedtextchecker.py. Each contact's
+// skills, interests and career goals become a set of normalized terms, and every pair sharing at
+// least one term is scored by exact overlap, Jaccard and TF-IDF cosine. Candidates come from an
+// inverted index (term -> contacts), so pairs with nothing in common are never looked at.
+//
+//   ./shared_text_engine [--fields=skills,interests,career_goals] [--min-overlap=1]
+//                        [--min-jaccard=0] [--min-tfidf=0] [--dry-run]
+//
+// At hundreds of thousands of contacts even the inverted index meets too many pairs, so --lsh
+// swaps it for MinHash buckets (see minhash_lsh.h) and only verifies pairs that collide:
+//
+//   --lsh                   candidates from banded MinHash instead of the inverted index
+//   --lsh-threshold=0.5     target Jaccard; lower finds more pairs (recall), higher fewer (speed)
+//   --lsh-hashes=64         signature length; longer gives a sharper cut at more hashing cost
+//   --match=<contact id>    look one contact up in the stored buckets and print its matches
+//
+// Exact terms miss "learn ML" vs "get into machine learning" style matches, so --embed scores
+// every pair by the cosine of hashed n-gram embeddings instead (text_embedding.h):
+//
+//   --embed                 keep pairs whose embeddings are close, whether or not a term is shared
+//   --min-cosine=0.5        how close; shared terms are still reported in the label when there are any
+//   --nearest=<contact id>  top --k=10 contacts by stored embedding, printed as JSON
+//   --ann                   with --embed: only compare each contact to its --ann-k=32 nearest
+//                           neighbours from an HNSW graph (hnsw_index.h) instead of everyone
+//
+// --update=<ids> recomputes only the pairs touching those contacts, against the inverted index
+// (or the embeddings with --embed), and swaps their rows in one transaction; rows naming people
+// who no longer exist go too. Scores of untouched pairs keep the idf they were written with
+// until the next full run. contacts.hnsw, if present, is refreshed for the same ids.
+//
+// When a model should still make the final call, --candidates prints the pairs worth asking
+// about instead of writing tables: pairs sharing a term, pairs whose embeddings are within
+// --min-cosine (0.35 here) among each contact's --ann-k=32 nearest neighbours, and pairs in the
+// same industry within --industry-cosine=0.15.
+// They come out as JSON chunks of at most --chunk-pairs=200 pairs and --chunk-chars=12000
+// characters of text, along with how much of the all-pairs list was pruned. Pairs whose two
+// texts a model has already judged are answered from pair_cache in text_index.db instead (see
+// pair_content_key), so a rerun only sends pairs where one side's text changed.
+//
+// contacts.hnsw, next to my_database.db, holds one vector per contact (all three fields) for the
+// "similar/<name>" view in generate_edges:
+//
+//   --index                 rebuild contacts.hnsw from scratch
+//   --index-update=<ids>    re-embed these contacts; ids that no longer exist are removed
+//
+// Terms go through synonyms.txt first (term_dictionary.h), so "bench 215" and "get stronger"
+// both count as "strength training". --dictionary=<file> picks another file, --no-dictionary
+// compares the raw text.
+
+enum Field {
+    FIELD_SKILLS,
+    FIELD_INTERESTS,
+    FIELD_GOALS,
+    FIELD_COUNT
+};
+
+struct PairTable {
+    const char* field;        // feature column name
+    const char* dbFile;
+    const char* table;
+    const char* labelColumn;
+    bool words;               // free text: compare words instead of comma separated phrases
+};
+
+const PairTable PAIR_TABLES[FIELD_COUNT] = {
+    {"skills",       "skill_edges.db",     "shared_skills",  "shared_skills",    false},
+    {"interests",    "interests_edges.db", "interest_edges", "shared_interests", false},
+    {"career_goals", "goals_edges.db",     "share_goals",    "shared_goal",      true},
+};
+
+// words that say nothing about what two goals have in common
+const std::set<std::string> STOPWORDS = {
+    "a", "an", "the", "and", "or", "to", "of", "in", "on", "at", "for", "with", "by", "from",
+    "into", "about", "as", "is", "are", "be", "i", "me", "my", "it", "its", "that", "this"
+};
+
+
+struct Contact {
+    int id;
+    std::string name;
+    std::string fields[FIELD_COUNT];
+    std::string industry;
+};
+
+
+std::string getSafeText(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+
+bool exec(sqlite3* db, const std::string& sql) {
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), NULL, 0, &errorMessage) != SQLITE_OK) {
+        std::cerr << "SQL error: " << errorMessage << "\n  in: " << sql << std::endl;
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    return true;
+}
+
+
+// every contact, or only the given ids
+std::vector<Contact> load_contacts(const std::string& db_path, const std::vector<int>& ids = {}) {
+    std::vector<Contact> contacts;
+
+    sqlite3* db;
+    if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return contacts;
+    }
+
+    const char* query = R"(
+        SELECT contacts.id, contacts.name, profile.skills, background.interests, profile.career_goals,
+               employment.industry
+        FROM contacts
+        LEFT JOIN background ON contacts.id = background.contact_id
+        LEFT JOIN profile ON contacts.id = profile.contact_id
+        LEFT JOIN employment ON contacts.id = employment.contact_id
+    )";
+    std::string sql = std::string(query) + (ids.empty() ? " ORDER BY contacts.id;" : " WHERE contacts.id = ?;");
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Query error: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return contacts;
+    }
+
+    size_t next = 0;
+    do {
+        if (!ids.empty()) {
+            sqlite3_reset(stmt);
+            sqlite3_bind_int(stmt, 1, ids[next]);
+        }
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            Contact c;
+            c.id = sqlite3_column_int(stmt, 0);
+            c.name = getSafeText(stmt, 1);
+            c.fields[FIELD_SKILLS] = getSafeText(stmt, 2);
+            c.fields[FIELD_INTERESTS] = getSafeText(stmt, 3);
+            c.fields[FIELD_GOALS] = getSafeText(stmt, 4);
+            c.industry = getSafeText(stmt, 5);
+            if (!c.name.empty()) contacts.push_back(c);
+        }
+    } while (++next < ids.size());
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return contacts;
+}
+
+
+// synonyms.txt compiled at startup; empty (plain splitting) with --no-dictionary
+TermDictionary dictionary;
+bool useDictionary = false;
+
+
+std::vector<std::string> field_terms(const std::string& text, bool words) {
+    if (!words) return useDictionary ? dictionary.canonicalize_items(text) : split_values(text);
+
+    std::vector<std::string> terms;
+    for (auto& word : useDictionary ? dictionary.canonicalize_words(text) : split_words(text)) {
+        if (word.size() > 1 && !STOPWORDS.count(word)) terms.push_back(word);
+    }
+    return terms;
+}
+
+
+// per field: each contact's term set plus the inverted index over it
+struct TermSets {
+    Interner terms;
+    std::vector<std::vector<uint32_t>> sets;      // contact -> sorted term ids
+    std::vector<std::vector<uint32_t>> postings;  // term -> contacts, ascending
+    std::vector<double> idf;                      // term -> log(N / df)
+    std::vector<double> norm;                     // contact -> length of its tf-idf vector
+    std::vector<uint64_t> hashes;                 // term -> hash_term(text), what MinHash works on
+};
+
+
+TermSets build_term_sets(const std::vector<Contact>& contacts, Field field) {
+    TermSets t;
+    t.sets.resize(contacts.size());
+
+    for (uint32_t c = 0; c < contacts.size(); ++c) {
+        auto& set = t.sets[c];
+        for (const auto& term : field_terms(contacts[c].fields[field], PAIR_TABLES[field].words)) {
+            set.push_back(t.terms.intern(term));
+        }
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+    }
+
+    t.postings.resize(t.terms.size());
+    t.hashes.resize(t.terms.size());
+    for (size_t term = 0; term < t.terms.size(); ++term) t.hashes[term] = hash_term(t.terms.names[term]);
+    for (uint32_t c = 0; c < contacts.size(); ++c) {
+        for (uint32_t term : t.sets[c]) t.postings[term].push_back(c);
+    }
+
+    double n = static_cast<double>(contacts.size());
+    t.idf.resize(t.terms.size());
+    for (size_t term = 0; term < t.postings.size(); ++term) {
+        t.idf[term] = std::log(n / t.postings[term].size());
+    }
+
+    t.norm.resize(contacts.size());
+    for (uint32_t c = 0; c < contacts.size(); ++c) {
+        double sum = 0.0;
+        for (uint32_t term : t.sets[c]) sum += t.idf[term] * t.idf[term];
+        t.norm[c] = std::sqrt(sum);
+    }
+
+    return t;
+}
+
+
+struct PairScore {
+    uint32_t a, b;      // contact indices, a < b
+    uint32_t overlap;   // shared terms
+    double jaccard;
+    double tfidf;       // cosine of the binary tf-idf vectors
+    double cosine = 0;  // cosine of the n-gram embeddings, only filled in by --embed
+};
+
+struct OverlapOptions {
+    uint32_t minOverlap = 1;
+    double minJaccard = 0.0;
+    double minTfidf = 0.0;
+};
+
+
+PairScore score_pair(const TermSets& t, uint32_t a, uint32_t b, uint32_t overlap, double dot) {
+    PairScore p;
+    p.a = a;
+    p.b = b;
+    p.overlap = overlap;
+    double unionSize = static_cast<double>(t.sets[a].size() + t.sets[b].size() - overlap);
+    p.jaccard = unionSize > 0 ? overlap / unionSize : 0.0;
+    double denom = t.norm[a] * t.norm[b];
+    p.tfidf = denom > 0 ? dot / denom : 0.0;
+    p.cosine = 0.0;
+    return p;
+}
+
+
+bool keep_pair(const PairScore& p, const OverlapOptions& options) {
+    return p.overlap >= options.minOverlap && p.jaccard >= options.minJaccard && p.tfidf >= options.minTfidf;
+}
+
+
+// Every pair sharing a term, found by walking each contact's posting lists into a dense
+// accumulator. Contacts are split into blocks across the pool; each block owns its accumulator.
+std::vector<PairScore> compute_overlaps(const TermSets& t, const OverlapOptions& options, size_t& candidates) {
+    uint32_t n = static_cast<uint32_t>(t.sets.size());
+    std::vector<PairScore> pairs;
+    std::mutex pairsMutex;
+    size_t candidateTotal = 0;
+
+    parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+        std::vector<uint32_t> count(n, 0);
+        std::vector<double> dot(n, 0.0);
+        std::vector<uint32_t> touched;
+        std::vector<PairScore> local;
+        size_t localCandidates = 0;
+
+        for (uint32_t a = static_cast<uint32_t>(begin); a < end; ++a) {
+            for (uint32_t term : t.sets[a]) {
+                const auto& posting = t.postings[term];
+                double w = t.idf[term] * t.idf[term];
+                // only partners after a, so each pair is counted from one side
+                for (auto it = std::upper_bound(posting.begin(), posting.end(), a); it != posting.end(); ++it) {
+                    if (count[*it]++ == 0) touched.push_back(*it);
+                    dot[*it] += w;
+                }
+            }
+
+            localCandidates += touched.size();
+            for (uint32_t b : touched) {
+                PairScore p = score_pair(t, a, b, count[b], dot[b]);
+                if (keep_pair(p, options)) local.push_back(p);
+                count[b] = 0;
+                dot[b] = 0.0;
+            }
+            touched.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(pairsMutex);
+        pairs.insert(pairs.end(), local.begin(), local.end());
+        candidateTotal += localCandidates;
+    }, 256);
+
+    std::sort(pairs.begin(), pairs.end(), [](const PairScore& x, const PairScore& y) {
+        return x.a != y.a ? x.a < y.a : x.b < y.b;
+    });
+    candidates = candidateTotal;
+    return pairs;
+}
+
+
+// Pairs between the changed contacts and everyone else: the same accumulator walk as
+// compute_overlaps, but over whole posting lists for just these rows, so one added contact
+// costs O(its postings) rather than a rebuild.
+std::vector<PairScore> compute_contact_overlaps(const TermSets& t, const std::vector<uint32_t>& changed,
+                                                const OverlapOptions& options, size_t& candidates) {
+    uint32_t n = static_cast<uint32_t>(t.sets.size());
+    std::vector<char> isChanged(n, 0);
+    for (uint32_t c : changed) isChanged[c] = 1;
+
+    std::vector<uint32_t> count(n, 0);
+    std::vector<double> dot(n, 0.0);
+    std::vector<uint32_t> touched;
+    std::vector<PairScore> pairs;
+    candidates = 0;
+
+    for (uint32_t a : changed) {
+        for (uint32_t term : t.sets[a]) {
+            double w = t.idf[term] * t.idf[term];
+            for (uint32_t b : t.postings[term]) {
+                // a pair of two changed contacts is counted from its lower side only
+                if (b == a || (isChanged[b] && b < a)) continue;
+                if (count[b]++ == 0) touched.push_back(b);
+                dot[b] += w;
+            }
+        }
+
+        candidates += touched.size();
+        for (uint32_t b : touched) {
+            PairScore p = score_pair(t, std::min(a, b), std::max(a, b), count[b], dot[b]);
+            if (keep_pair(p, options)) pairs.push_back(p);
+            count[b] = 0;
+            dot[b] = 0.0;
+        }
+        touched.clear();
+    }
+    return pairs;
+}
+
+
+// exact overlap and tf-idf dot product of two sorted term sets
+PairScore exact_pair(const TermSets& t, uint32_t a, uint32_t b) {
+    const auto& x = t.sets[a];
+    const auto& y = t.sets[b];
+    // LSH candidates usually do share terms, so one merge (galloping on skewed sizes) gives both
+    // the overlap and the terms for the dot product; the buffer is reused by each pool thread
+    thread_local std::vector<uint32_t> shared;
+    if (shared.size() < std::min(x.size(), y.size())) shared.resize(std::min(x.size(), y.size()));
+    uint32_t overlap = static_cast<uint32_t>(intersect_sorted(x.data(), x.size(), y.data(), y.size(), shared.data()));
+
+    double dot = 0.0;
+    for (uint32_t i = 0; i < overlap; ++i) dot += t.idf[shared[i]] * t.idf[shared[i]];
+    return score_pair(t, a, b, overlap, dot);
+}
+
+
+std::vector<uint32_t> contact_signature(const TermSets& t, uint32_t c, const LshParams& params) {
+    std::vector<uint64_t> hashes;
+    hashes.reserve(t.sets[c].size());
+    for (uint32_t term : t.sets[c]) hashes.push_back(t.hashes[term]);
+    return minhash_signature(hashes, params.hashes());
+}
+
+
+// Candidates are the pairs that land in the same bucket in at least one band; each is then
+// checked with an exact intersection. Cost follows the bucket sizes rather than n^2.
+std::vector<PairScore> compute_lsh_overlaps(const TermSets& t, const OverlapOptions& options, const LshParams& params,
+                                            std::vector<std::vector<uint32_t>>& signatures, size_t& candidates) {
+    uint32_t n = static_cast<uint32_t>(t.sets.size());
+    signatures.assign(n, {});
+
+    parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) signatures[c] = contact_signature(t, static_cast<uint32_t>(c), params);
+    }, 256);
+
+    PairMap<char> seen(n * 4);
+    std::vector<uint64_t> candidateKeys;
+
+    for (int band = 0; band < params.bands; ++band) {
+        std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+        for (uint32_t c = 0; c < n; ++c) {
+            if (t.sets[c].empty()) continue;
+            buckets[band_key(signatures[c], params, band)].push_back(c);
+        }
+
+        for (const auto& bucket : buckets) {
+            const auto& members = bucket.second;
+            for (size_t i = 0; i < members.size(); ++i) {
+                for (size_t j = i + 1; j < members.size(); ++j) {
+                    uint64_t key = pair_key(members[i], members[j]);
+                    char& mark = seen[key];
+                    if (!mark) {
+                        mark = 1;
+                        candidateKeys.push_back(key);
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(candidateKeys.begin(), candidateKeys.end());
+    candidates = candidateKeys.size();
+
+    std::vector<PairScore> scored(candidateKeys.size());
+    std::vector<char> keep(candidateKeys.size(), 0);
+
+    parallel_for(shared_pool(), 0, candidateKeys.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            scored[i] = exact_pair(t, pair_first(candidateKeys[i]), pair_second(candidateKeys[i]));
+            keep[i] = keep_pair(scored[i], options);
+        }
+    });
+
+    std::vector<PairScore> pairs;
+    for (size_t i = 0; i < scored.size(); ++i) {
+        if (keep[i]) pairs.push_back(scored[i]);
+    }
+    return pairs;
+}
+
+
+// one unit-length embedding per contact, row-major in contact order
+std::vector<float> embed_contacts(const std::vector<Contact>& contacts, Field field) {
+    std::vector<float> matrix(contacts.size() * EMBEDDING_DIM);
+
+    parallel_for(shared_pool(), 0, contacts.size(), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            std::vector<float> vector = embed_terms(field_terms(contacts[c].fields[field], PAIR_TABLES[field].words));
+            std::copy(vector.begin(), vector.end(), matrix.begin() + c * EMBEDDING_DIM);
+        }
+    }, 64);
+    return matrix;
+}
+
+
+// All pairs by embedding cosine. Every pair is a candidate, but each is one SIMD dot product
+// over a contiguous matrix, so this runs at memory speed. Rows are walked in tiles so the
+// partner rows stay in cache while a block of contacts is compared against them.
+std::vector<PairScore> compute_embedding_overlaps(const TermSets& t, const std::vector<float>& matrix,
+                                                  const OverlapOptions& options, double minCosine, size_t& candidates) {
+    const size_t TILE = 64;
+    uint32_t n = static_cast<uint32_t>(t.sets.size());
+    DotKernel dot = dot_kernel();
+    std::vector<PairScore> pairs;
+    std::mutex pairsMutex;
+
+    parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+        std::vector<PairScore> local;
+        for (size_t tile = begin + 1; tile < n; tile += TILE) {
+            size_t tileEnd = std::min<size_t>(tile + TILE, n);
+            for (size_t a = begin; a < end && a + 1 < tileEnd; ++a) {
+                const float* row = matrix.data() + a * EMBEDDING_DIM;
+                for (size_t b = std::max(tile, a + 1); b < tileEnd; ++b) {
+                    float cosine = dot(row, matrix.data() + b * EMBEDDING_DIM, EMBEDDING_DIM);
+                    if (cosine < minCosine) continue;
+
+                    PairScore p = exact_pair(t, static_cast<uint32_t>(a), static_cast<uint32_t>(b));
+                    p.cosine = cosine;
+                    if (keep_pair(p, options)) local.push_back(p);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(pairsMutex);
+        pairs.insert(pairs.end(), local.begin(), local.end());
+    }, 64);
+
+    std::sort(pairs.begin(), pairs.end(), [](const PairScore& x, const PairScore& y) {
+        return x.a != y.a ? x.a < y.a : x.b < y.b;
+    });
+    candidates = static_cast<size_t>(n) * (n - 1) / 2;
+    return pairs;
+}
+
+
+// --update with --embed: each changed contact's row against every other row
+std::vector<PairScore> compute_contact_embedding_overlaps(const TermSets& t, const std::vector<float>& matrix,
+                                                          const std::vector<uint32_t>& changed, const OverlapOptions& options,
+                                                          double minCosine, size_t& candidates) {
+    uint32_t n = static_cast<uint32_t>(t.sets.size());
+    std::vector<char> isChanged(n, 0);
+    for (uint32_t c : changed) isChanged[c] = 1;
+
+    DotKernel dot = dot_kernel();
+    std::vector<PairScore> pairs;
+    candidates = 0;
+
+    for (uint32_t a : changed) {
+        const float* row = matrix.data() + static_cast<size_t>(a) * EMBEDDING_DIM;
+        for (uint32_t b = 0; b < n; ++b) {
+            if (b == a || (isChanged[b] && b < a)) continue;
+            ++candidates;
+            float cosine = dot(row, matrix.data() + static_cast<size_t>(b) * EMBEDDING_DIM, EMBEDDING_DIM);
+            if (cosine < minCosine) continue;
+
+            PairScore p = exact_pair(t, std::min(a, b), std::max(a, b));
+            p.cosine = cosine;
+            if (keep_pair(p, options)) pairs.push_back(p);
+        }
+    }
+    return pairs;
+}
+
+
+// Same as compute_embedding_overlaps, but each contact is only scored against its approximate
+// nearest neighbours, so the cost grows with n * annK rather than n^2. A pair can be missed when
+// neither side has the other among its neighbours.
+std::vector<PairScore> compute_ann_overlaps(const TermSets& t, const std::vector<float>& matrix,
+                                            const OverlapOptions& options, double minCosine, size_t annK,
+                                            size_t& candidates) {
+    uint32_t n = static_cast<uint32_t>(t.sets.size());
+    HnswIndex index;
+    for (uint32_t c = 0; c < n; ++c) index.insert(c, matrix.data() + static_cast<size_t>(c) * EMBEDDING_DIM);
+
+    std::vector<std::vector<uint64_t>> found(n);
+    parallel_for(shared_pool(), 0, n, [&](size_t begin, size_t end) {
+        for (size_t a = begin; a < end; ++a) {
+            for (const auto& hit : index.search(matrix.data() + a * EMBEDDING_DIM, annK + 1, std::max<size_t>(64, annK * 2))) {
+                if (hit.first != a && hit.second >= minCosine) found[a].push_back(pair_key(static_cast<uint32_t>(a), hit.first));
+            }
+        }
+    }, 64);
+
+    std::vector<uint64_t> keys;
+    for (const auto& list : found) keys.insert(keys.end(), list.begin(), list.end());
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    candidates = keys.size();
+
+    std::vector<PairScore> pairs;
+    DotKernel dot = dot_kernel();
+    for (uint64_t key : keys) {
+        uint32_t a = pair_first(key), b = pair_second(key);
+        PairScore p = exact_pair(t, a, b);
+        p.cosine = dot(matrix.data() + static_cast<size_t>(a) * EMBEDDING_DIM, matrix.data() + static_cast<size_t>(b) * EMBEDDING_DIM, EMBEDDING_DIM);
+        if (keep_pair(p, options)) pairs.push_back(p);
+    }
+    return pairs;
+}
+
+
+// Order-independent key for "these two texts", used by pair_cache. Texts are normalized first,
+// so a re-saved contact with only case or spacing changes still hits.
+uint64_t text_key(const std::string& text) {
+    return hash_term(normalize_value(text));
+}
+
+uint64_t pair_content_key(uint64_t a, uint64_t b) {
+    if (a > b) std::swap(a, b);
+    // positive so it round-trips through a SQLite integer
+    return mix64(a ^ mix64(b)) >> 1;
+}
+
+
+struct BlockingOptions {
+    double minCosine = 0.35;
+    double industryCosine = 0.15;   // looser cosine bar for two people in the same industry
+    size_t chunkPairs = 200;
+    size_t chunkChars = 12000;
+    size_t annK = 32;               // embedding neighbours looked up per contact
+};
+
+
+// Cheap signals decide which pairs a model gets to judge: any shared term (from the inverted
+// index), embedding cosine, and a shared industry with a weaker cosine. Only contacts with text
+// in the field take part, the same pairs sharedtextchecker.py used to send wholesale. No source
+// walks all pairs: the embedding pairs are each contact's --ann-k nearest neighbours in an HNSW
+// graph, as with --ann, and the industry pairs come from an inverted index over industry ids.
+json blocking_candidates(const std::vector<Contact>& contacts, Field field, const BlockingOptions& options,
+                         const std::unordered_map<uint64_t, std::string>& cache) {
+    const PairTable& table = PAIR_TABLES[field];
+    TermSets terms = build_term_sets(contacts, field);
+    std::vector<float> matrix = embed_contacts(contacts, field);
+
+    size_t overlapCandidates = 0;
+    std::vector<uint64_t> keys;
+    for (const auto& p : compute_overlaps(terms, OverlapOptions(), overlapCandidates)) keys.push_back(pair_key(p.a, p.b));
+
+    Interner industryNames;
+    std::vector<std::vector<uint32_t>> byIndustry;
+    std::vector<uint32_t> active;
+    HnswIndex index;
+    for (uint32_t c = 0; c < contacts.size(); ++c) {
+        if (normalize_value(contacts[c].fields[field]).empty()) continue;
+        active.push_back(c);
+        index.insert(c, matrix.data() + static_cast<size_t>(c) * EMBEDDING_DIM);
+
+        std::vector<uint32_t> ids;
+        for (const auto& value : split_values(contacts[c].industry)) ids.push_back(industryNames.intern(value));
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        for (uint32_t id : ids) {
+            if (id >= byIndustry.size()) byIndustry.resize(id + 1);
+            byIndustry[id].push_back(c);
+        }
+    }
+
+    std::vector<std::vector<uint64_t>> found(active.size());
+    parallel_for(shared_pool(), 0, active.size(), [&](size_t begin, size_t end) {
+        size_t ef = std::max<size_t>(64, options.annK * 2);
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t a = active[i];
+            for (const auto& hit : index.search(matrix.data() + static_cast<size_t>(a) * EMBEDDING_DIM, options.annK + 1, ef)) {
+                if (hit.first != a && hit.second >= options.minCosine) found[i].push_back(pair_key(a, hit.first));
+            }
+        }
+    }, 64);
+    for (const auto& list : found) keys.insert(keys.end(), list.begin(), list.end());
+
+    // members of an industry are in contact order, so a < b
+    DotKernel dot = dot_kernel();
+    std::mutex keysMutex;
+    parallel_for(shared_pool(), 0, byIndustry.size(), [&](size_t begin, size_t end) {
+        std::vector<uint64_t> local;
+        for (size_t id = begin; id < end; ++id) {
+            const auto& members = byIndustry[id];
+            for (size_t i = 0; i < members.size(); ++i) {
+                const float* row = matrix.data() + static_cast<size_t>(members[i]) * EMBEDDING_DIM;
+                for (size_t j = i + 1; j < members.size(); ++j) {
+                    float cosine = dot(row, matrix.data() + static_cast<size_t>(members[j]) * EMBEDDING_DIM, EMBEDDING_DIM);
+                    if (cosine >= options.industryCosine) local.push_back(pair_key(members[i], members[j]));
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(keysMutex);
+        keys.insert(keys.end(), local.begin(), local.end());
+    }, 1);
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<uint64_t> textKeys(contacts.size());
+    for (uint32_t c : active) textKeys[c] = text_key(contacts[c].fields[field]);
+
+    size_t total = active.size() * (active.size() > 0 ? active.size() - 1 : 0) / 2;
+    size_t candidates = 0;
+    size_t cacheHits = 0;
+    json cachedPairs = json::array();
+    json chunks = json::array();
+    json chunk = json::array();
+    json chunkKeys = json::array();
+    size_t chunkChars = 0;
+
+    for (uint64_t key : keys) {
+        const Contact& a = contacts[pair_first(key)];
+        const Contact& b = contacts[pair_second(key)];
+        ++candidates;
+
+        uint64_t contentKey = pair_content_key(textKeys[pair_first(key)], textKeys[pair_second(key)]);
+        auto hit = cache.find(contentKey);
+        if (hit != cache.end()) {
+            ++cacheHits;
+            // an empty label means the model already said they share nothing
+            if (!hit->second.empty()) cachedPairs.push_back({a.name, b.name, hit->second});
+            continue;
+        }
+
+        size_t chars = a.name.size() + a.fields[field].size() + b.name.size() + b.fields[field].size();
+        if (!chunk.empty() && (chunk.size() >= options.chunkPairs || chunkChars + chars > options.chunkChars)) {
+            chunks.push_back({{"pairs", chunk}, {"keys", chunkKeys}});
+            chunk = json::array();
+            chunkKeys = json::array();
+            chunkChars = 0;
+        }
+        chunk.push_back({a.name, a.fields[field], b.name, b.fields[field]});
+        chunkKeys.push_back(contentKey);
+        chunkChars += chars;
+    }
+    if (!chunk.empty()) chunks.push_back({{"pairs", chunk}, {"keys", chunkKeys}});
+
+    double pruned = total > 0 ? 1.0 - static_cast<double>(candidates) / total : 0.0;
+    std::cerr << table.field << ": " << candidates << " of " << total << " pairs kept (" << pruned * 100.0
+              << "% pruned), " << cacheHits << " answered from cache, " << chunks.size() << " chunks to send" << std::endl;
+
+    return {{"total_pairs", total}, {"candidates", candidates}, {"prune_ratio", pruned}, {"cache_hits", cacheHits},
+            {"cached_pairs", cachedPairs}, {"chunks", chunks}};
+}
+
+
+const char* CONTACT_INDEX_FILE = "contacts.hnsw";
+
+
+// one vector for the whole contact: each non-empty field embedded on its own and summed, so a
+// long goals paragraph doesn't drown out a two-item skills list
+std::vector<float> contact_vector(const Contact& c) {
+    std::vector<float> vector(EMBEDDING_DIM, 0.0f);
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        std::vector<std::string> terms = field_terms(c.fields[f], PAIR_TABLES[f].words);
+        if (terms.empty()) continue;
+        std::vector<float> part = embed_terms(terms);
+        for (int i = 0; i < EMBEDDING_DIM; ++i) vector[i] += part[i];
+    }
+
+    double sum = 0.0;
+    for (float x : vector) sum += static_cast<double>(x) * x;
+    if (sum > 0.0) {
+        float scale = static_cast<float>(1.0 / std::sqrt(sum));
+        for (float& x : vector) x *= scale;
+    }
+    return vector;
+}
+
+
+bool build_contact_index(const std::vector<Contact>& contacts) {
+    HnswIndex index;
+    for (const auto& c : contacts) {
+        std::vector<float> vector = contact_vector(c);
+        index.insert(static_cast<uint32_t>(c.id), vector.data());
+    }
+    if (!index.save(CONTACT_INDEX_FILE)) return false;
+    std::cout << CONTACT_INDEX_FILE << ": " << index.size() << " contacts indexed" << std::endl;
+    return true;
+}
+
+
+// re-embeds the given contacts in place; ids missing from my_database.db are dropped
+bool update_contact_index(const std::vector<int>& ids) {
+    // a missing or unreadable index would otherwise be saved back holding only these contacts
+    HnswIndex index;
+    if (!index.load(CONTACT_INDEX_FILE)) {
+        std::cerr << "Could not read " << CONTACT_INDEX_FILE << ", rebuilding it for every contact" << std::endl;
+        return build_contact_index(load_contacts("my_database.db"));
+    }
+
+    std::map<int, Contact> current;
+    for (const auto& c : load_contacts("my_database.db", ids)) current[c.id] = c;
+
+    int inserted = 0, removed = 0;
+    for (int id : ids) {
+        auto it = current.find(id);
+        if (it != current.end()) {
+            std::vector<float> vector = contact_vector(it->second);
+            index.insert(static_cast<uint32_t>(id), vector.data());
+            ++inserted;
+        } else if (index.remove(static_cast<uint32_t>(id))) {
+            ++removed;
+        }
+    }
+
+    // removed and replaced nodes still cost search time; rebuild once they outnumber live ones
+    if (index.node_count() > 2 * index.size()) index.compact();
+
+    if (!index.save(CONTACT_INDEX_FILE)) return false;
+    std::cout << CONTACT_INDEX_FILE << ": " << inserted << " updated, " << removed << " removed, "
+              << index.size() << " contacts indexed" << std::endl;
+    return true;
+}
+
+
+const char* TEXT_INDEX_SCHEMA = R"(
+    CREATE TABLE IF NOT EXISTS lsh_params (
+        field TEXT PRIMARY KEY,
+        bands INTEGER NOT NULL,
+        rows INTEGER NOT NULL
+    );
+    CREATE TABLE IF NOT EXISTS minhash_signatures (
+        contact_id INTEGER NOT NULL,
+        field TEXT NOT NULL,
+        signature BLOB NOT NULL,
+        PRIMARY KEY (contact_id, field)
+    );
+    CREATE TABLE IF NOT EXISTS lsh_buckets (
+        field TEXT NOT NULL,
+        band INTEGER NOT NULL,
+        bucket INTEGER NOT NULL,
+        contact_id INTEGER NOT NULL
+    );
+    CREATE INDEX IF NOT EXISTS lsh_buckets_lookup ON lsh_buckets (field, band, bucket);
+    CREATE INDEX IF NOT EXISTS lsh_buckets_contact ON lsh_buckets (field, contact_id);
+    CREATE TABLE IF NOT EXISTS pair_cache (
+        field TEXT NOT NULL,
+        pair_hash INTEGER NOT NULL,
+        label TEXT NOT NULL,
+        PRIMARY KEY (field, pair_hash)
+    );
+    CREATE TABLE IF NOT EXISTS embeddings (
+        contact_id INTEGER NOT NULL,
+        field TEXT NOT NULL,
+        vector BLOB NOT NULL,
+        PRIMARY KEY (contact_id, field)
+    );
+)";
+
+
+sqlite3* open_text_index() {
+    sqlite3* db;
+    if (sqlite3_open("text_index.db", &db) != SQLITE_OK) {
+        std::cerr << "Cannot open text_index.db: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return nullptr;
+    }
+    if (!exec(db, TEXT_INDEX_SCHEMA)) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    return db;
+}
+
+
+// the three statements store_signature runs, prepared once for a whole batch of contacts
+struct SignatureStatements {
+    sqlite3_stmt* clear = nullptr;
+    sqlite3_stmt* sig = nullptr;
+    sqlite3_stmt* bucket = nullptr;
+
+    bool prepare(sqlite3* db) {
+        if (sqlite3_prepare_v2(db, "DELETE FROM lsh_buckets WHERE field = ? AND contact_id = ?;", -1, &clear, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO minhash_signatures (contact_id, field, signature) VALUES (?, ?, ?);", -1, &sig, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, "INSERT INTO lsh_buckets (field, band, bucket, contact_id) VALUES (?, ?, ?, ?);", -1, &bucket, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            finalize();
+            return false;
+        }
+        return true;
+    }
+
+    // safe to call more than once; must run before the connection closes
+    void finalize() {
+        sqlite3_finalize(clear);
+        sqlite3_finalize(sig);
+        sqlite3_finalize(bucket);
+        clear = sig = bucket = nullptr;
+    }
+};
+
+
+// replaces one contact's signature and bucket rows; caller holds the transaction
+bool store_signature(sqlite3* db, SignatureStatements& statements, const char* field, int contactId,
+                     const std::vector<uint32_t>& signature, const LshParams& params) {
+    sqlite3_bind_text(statements.clear, 1, field, -1, SQLITE_STATIC);
+    sqlite3_bind_int(statements.clear, 2, contactId);
+    bool ok = sqlite3_step(statements.clear) == SQLITE_DONE;
+    sqlite3_reset(statements.clear);
+
+    sqlite3_bind_int(statements.sig, 1, contactId);
+    sqlite3_bind_text(statements.sig, 2, field, -1, SQLITE_STATIC);
+    sqlite3_bind_blob(statements.sig, 3, signature.data(), static_cast<int>(signature.size() * sizeof(uint32_t)), SQLITE_STATIC);
+    ok = ok && sqlite3_step(statements.sig) == SQLITE_DONE;
+    sqlite3_reset(statements.sig);
+
+    // an empty set has no terms to match on, so it gets no buckets
+    for (int band = 0; ok && !empty_signature(signature) && band < params.bands; ++band) {
+        sqlite3_bind_text(statements.bucket, 1, field, -1, SQLITE_STATIC);
+        sqlite3_bind_int(statements.bucket, 2, band);
+        sqlite3_bind_int64(statements.bucket, 3, static_cast<sqlite3_int64>(band_key(signature, params, band)));
+        sqlite3_bind_int(statements.bucket, 4, contactId);
+        ok = sqlite3_step(statements.bucket) == SQLITE_DONE;
+        sqlite3_reset(statements.bucket);
+    }
+
+    if (!ok) std::cerr << "Signature write failed: " << sqlite3_errmsg(db) << std::endl;
+    return ok;
+}
+
+
+bool store_signatures(const PairTable& table, const std::vector<Contact>& contacts,
+                      const std::vector<std::vector<uint32_t>>& signatures, const LshParams& params) {
+    sqlite3* db = open_text_index();
+    if (!db) return false;
+
+    bool ok = exec(db, "BEGIN IMMEDIATE;");
+
+    sqlite3_stmt* stmt;
+    std::string field = table.field;
+    ok = ok && exec(db, "DELETE FROM minhash_signatures WHERE field = '" + field + "';") &&
+         exec(db, "DELETE FROM lsh_buckets WHERE field = '" + field + "';") &&
+         sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO lsh_params (field, bands, rows) VALUES (?, ?, ?);", -1, &stmt, nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_text(stmt, 1, table.field, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, params.bands);
+        sqlite3_bind_int(stmt, 3, params.rows);
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_finalize(stmt);
+    }
+
+    SignatureStatements statements;
+    ok = ok && statements.prepare(db);
+    for (size_t c = 0; ok && c < contacts.size(); ++c) {
+        ok = store_signature(db, statements, table.field, contacts[c].id, signatures[c], params);
+    }
+    statements.finalize();
+
+    ok = ok && exec(db, "COMMIT;");
+    if (!ok) exec(db, "ROLLBACK;");
+    sqlite3_close(db);
+    return ok;
+}
+
+
+// model answers recorded by sharedtextchecker.py, pair_content_key -> shared label ("" for none)
+std::unordered_map<uint64_t, std::string> load_pair_cache(const char* field) {
+    std::unordered_map<uint64_t, std::string> cache;
+    sqlite3* db = open_text_index();
+    if (!db) return cache;
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT pair_hash, label FROM pair_cache WHERE field = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, field, -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            cache[static_cast<uint64_t>(sqlite3_column_int64(stmt, 0))] = getSafeText(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+    return cache;
+}
+
+
+bool store_embeddings(const PairTable& table, const std::vector<Contact>& contacts, const std::vector<float>& matrix) {
+    sqlite3* db = open_text_index();
+    if (!db) return false;
+
+    sqlite3_stmt* insert = nullptr;
+    std::string field = table.field;
+    bool ok = exec(db, "BEGIN IMMEDIATE;") &&
+              exec(db, "DELETE FROM embeddings WHERE field = '" + field + "';") &&
+              sqlite3_prepare_v2(db, "INSERT INTO embeddings (contact_id, field, vector) VALUES (?, ?, ?);", -1, &insert, nullptr) == SQLITE_OK;
+
+    for (size_t c = 0; ok && c < contacts.size(); ++c) {
+        sqlite3_bind_int(insert, 1, contacts[c].id);
+        sqlite3_bind_text(insert, 2, table.field, -1, SQLITE_STATIC);
+        sqlite3_bind_blob(insert, 3, matrix.data() + c * EMBEDDING_DIM, EMBEDDING_DIM * sizeof(float), SQLITE_STATIC);
+        ok = sqlite3_step(insert) == SQLITE_DONE;
+        sqlite3_reset(insert);
+    }
+    if (!ok) std::cerr << "Embedding write failed: " << sqlite3_errmsg(db) << std::endl;
+    sqlite3_finalize(insert);
+
+    ok = ok && exec(db, "COMMIT;");
+    if (!ok) exec(db, "ROLLBACK;");
+    sqlite3_close(db);
+    return ok;
+}
+
+
+// Top k contacts closest to one contact, scanning the embeddings stored by the last --embed run.
+// The contact itself is embedded fresh, so it works for someone added since then.
+json nearest_contacts(int contactId, Field field, size_t k) {
+    json matches = json::array();
+    const PairTable& table = PAIR_TABLES[field];
+
+    std::vector<Contact> self = load_contacts("my_database.db", {contactId});
+    if (self.empty()) {
+        std::cerr << "No contact with id " << contactId << std::endl;
+        return matches;
+    }
+
+    sqlite3* db = open_text_index();
+    if (!db) return matches;
+
+    std::vector<int> ids;
+    std::vector<float> matrix;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT contact_id, vector FROM embeddings WHERE field = ? ORDER BY contact_id;", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, table.field, -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (sqlite3_column_bytes(stmt, 1) != static_cast<int>(EMBEDDING_DIM * sizeof(float))) continue;
+            const float* vector = static_cast<const float*>(sqlite3_column_blob(stmt, 1));
+            ids.push_back(sqlite3_column_int(stmt, 0));
+            matrix.insert(matrix.end(), vector, vector + EMBEDDING_DIM);
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+
+    if (ids.empty()) {
+        std::cerr << "No embeddings for " << table.field << " yet, run with --embed first" << std::endl;
+        return matches;
+    }
+
+    std::vector<float> query = embed_terms(field_terms(self[0].fields[field], table.words));
+    uint32_t skip = UINT32_MAX;
+    auto own = std::lower_bound(ids.begin(), ids.end(), contactId);
+    if (own != ids.end() && *own == contactId) skip = static_cast<uint32_t>(own - ids.begin());
+
+    auto best = top_k_cosine(matrix, query.data(), k, skip);
+
+    std::vector<int> bestIds;
+    for (const auto& hit : best) bestIds.push_back(ids[hit.first]);
+    std::map<int, std::string> names;
+    for (const auto& c : load_contacts("my_database.db", bestIds)) names[c.id] = c.name;
+
+    for (const auto& hit : best) {
+        int id = ids[hit.first];
+        matches.push_back({{"id", id}, {"name", names[id]}, {"cosine", hit.second}});
+    }
+    return matches;
+}
+
+
+// Matches one contact against the stored buckets without touching anyone else's terms: one
+// indexed lookup per band, then exact Jaccard on just the contacts that came back. The
+// contact's own signature is stored on the way, so it is findable by the next match.
+json match_contact(int contactId, Field field, const OverlapOptions& options) {
+    json matches = json::array();
+    const PairTable& table = PAIR_TABLES[field];
+
+    std::vector<Contact> self = load_contacts("my_database.db", {contactId});
+    if (self.empty()) {
+        std::cerr << "No contact with id " << contactId << std::endl;
+        return matches;
+    }
+
+    sqlite3* db = open_text_index();
+    if (!db) return matches;
+
+    LshParams params;
+    bool haveParams = false;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT bands, rows FROM lsh_params WHERE field = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, table.field, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            params.bands = sqlite3_column_int(stmt, 0);
+            params.rows = sqlite3_column_int(stmt, 1);
+            haveParams = true;
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!haveParams) {
+        std::cerr << "No LSH index for " << table.field << " yet, run with --lsh first" << std::endl;
+        sqlite3_close(db);
+        return matches;
+    }
+
+    std::vector<std::string> terms = field_terms(self[0].fields[field], table.words);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    std::vector<uint32_t> signature = minhash_signature(terms, params.hashes());
+
+    std::set<int> candidateIds;
+    if (!empty_signature(signature) &&
+        sqlite3_prepare_v2(db, "SELECT contact_id FROM lsh_buckets WHERE field = ? AND band = ? AND bucket = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+        for (int band = 0; band < params.bands; ++band) {
+            sqlite3_bind_text(stmt, 1, table.field, -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, band);
+            sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(band_key(signature, params, band)));
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                int id = sqlite3_column_int(stmt, 0);
+                if (id != contactId) candidateIds.insert(id);
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    SignatureStatements statements;
+    bool ok = exec(db, "BEGIN IMMEDIATE;") && statements.prepare(db) &&
+              store_signature(db, statements, table.field, contactId, signature, params);
+    statements.finalize();
+    exec(db, ok ? "COMMIT;" : "ROLLBACK;");
+    sqlite3_close(db);
+
+    // load_contacts treats an empty id list as "everyone"
+    if (candidateIds.empty()) return matches;
+
+    std::vector<Contact> candidates = load_contacts("my_database.db", std::vector<int>(candidateIds.begin(), candidateIds.end()));
+    std::set<std::string> mine(terms.begin(), terms.end());
+
+    for (const auto& other : candidates) {
+        if (other.id == contactId) continue;
+        std::vector<std::string> shared;
+        std::set<std::string> theirs;
+        for (const auto& term : field_terms(other.fields[field], table.words)) {
+            if (theirs.insert(term).second && mine.count(term)) shared.push_back(term);
+        }
+
+        double unionSize = static_cast<double>(mine.size() + theirs.size() - shared.size());
+        double jaccard = unionSize > 0 ? shared.size() / unionSize : 0.0;
+        if (shared.size() < options.minOverlap || jaccard < options.minJaccard) continue;
+
+        std::string label;
+        for (const auto& term : shared) label += (label.empty() ? "" : ", ") + term;
+        matches.push_back({{"id", other.id}, {"name", other.name}, {"jaccard", jaccard}, {"shared", label}});
+    }
+
+    return matches;
+}
+
+
+std::string shared_label(const TermSets& t, uint32_t a, uint32_t b) {
+    std::vector<uint32_t> shared = intersect_sorted(t.sets[a], t.sets[b]);
+
+    std::string label;
+    for (uint32_t term : shared) {
+        if (!label.empty()) label += ", ";
+        label += t.terms.names[term];
+    }
+    return label;
+}
+
+
+// creates the table if needed and adds the score columns to tables made by older scripts
+bool prepare_pair_table(sqlite3* db, const PairTable& table) {
+    std::string create = std::string("CREATE TABLE IF NOT EXISTS ") + table.table + " ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, person1 TEXT, person2 TEXT, " + table.labelColumn + " TEXT, "
+        "overlap INTEGER, jaccard REAL, tfidf REAL, cosine REAL, UNIQUE(person1, person2));";
+    if (!exec(db, create)) return false;
+
+    std::set<std::string> columns;
+    sqlite3_stmt* stmt;
+    std::string info = std::string("PRAGMA table_info(") + table.table + ");";
+    if (sqlite3_prepare_v2(db, info.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) columns.insert(getSafeText(stmt, 1));
+    sqlite3_finalize(stmt);
+
+    const char* scoreColumns[][2] = {{"overlap", "INTEGER"}, {"jaccard", "REAL"}, {"tfidf", "REAL"}, {"cosine", "REAL"}};
+    for (const auto& column : scoreColumns) {
+        if (columns.count(column[0])) continue;
+        if (!exec(db, std::string("ALTER TABLE ") + table.table + " ADD COLUMN " + column[0] + " " + column[1] + ";")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool write_pair_table(const PairTable& table, const std::vector<Contact>& contacts, const TermSets& t,
+                      const std::vector<PairScore>& pairs) {
+    sqlite3* db;
+    if (sqlite3_open(table.dbFile, &db) != SQLITE_OK) {
+        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+
+    if (!prepare_pair_table(db, table) || !exec(db, "BEGIN IMMEDIATE;")) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    std::string insertSql = std::string("INSERT OR REPLACE INTO ") + table.table +
+        " (person1, person2, " + table.labelColumn + ", overlap, jaccard, tfidf, cosine) VALUES (?, ?, ?, ?, ?, ?, ?);";
+    sqlite3_stmt* insert;
+    bool ok = exec(db, std::string("DELETE FROM ") + table.table + ";") &&
+              sqlite3_prepare_v2(db, insertSql.c_str(), -1, &insert, nullptr) == SQLITE_OK;
+
+    if (ok) {
+        for (const auto& p : pairs) {
+            const std::string& person1 = contacts[p.a].name;
+            const std::string& person2 = contacts[p.b].name;
+            if (person1 == person2) continue;
+
+            std::string label = shared_label(t, p.a, p.b);
+            sqlite3_bind_text(insert, 1, person1.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(insert, 2, person2.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(insert, 3, label.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(insert, 4, static_cast<int>(p.overlap));
+            sqlite3_bind_double(insert, 5, p.jaccard);
+            sqlite3_bind_double(insert, 6, p.tfidf);
+            sqlite3_bind_double(insert, 7, p.cosine);
+            if (sqlite3_step(insert) != SQLITE_DONE) {
+                std::cerr << "Insert failed: " << sqlite3_errmsg(db) << std::endl;
+                ok = false;
+                break;
+            }
+            sqlite3_reset(insert);
+        }
+        sqlite3_finalize(insert);
+    }
+
+    ok = ok && exec(db, "COMMIT;");
+    if (!ok) exec(db, "ROLLBACK;");
+
+    sqlite3_close(db);
+    return ok;
+}
+
+
+// Replaces the rows of the changed contacts with freshly computed pairs, and drops rows for
+// people no longer in my_database.db (deleted or renamed), all in one transaction.
+bool update_pair_table(const PairTable& table, const std::vector<Contact>& contacts, const TermSets& t,
+                       const std::vector<uint32_t>& changed, const std::vector<PairScore>& pairs) {
+    sqlite3* db;
+    if (sqlite3_open(table.dbFile, &db) != SQLITE_OK) {
+        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+
+    if (!prepare_pair_table(db, table) || !exec(db, "ATTACH DATABASE 'my_database.db' AS main_db;") ||
+        !exec(db, "BEGIN IMMEDIATE;")) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    std::string tableName = table.table;
+    std::string deleteSql = "DELETE FROM " + tableName + " WHERE person1 = ?1 OR person2 = ?1;";
+    std::string insertSql = "INSERT OR REPLACE INTO " + tableName + " (person1, person2, " + table.labelColumn +
+                            ", overlap, jaccard, tfidf, cosine) VALUES (?, ?, ?, ?, ?, ?, ?);";
+    sqlite3_stmt *remove = nullptr, *insert = nullptr;
+    bool ok = sqlite3_prepare_v2(db, deleteSql.c_str(), -1, &remove, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, insertSql.c_str(), -1, &insert, nullptr) == SQLITE_OK;
+
+    int removed = 0;
+    for (size_t i = 0; ok && i < changed.size(); ++i) {
+        sqlite3_bind_text(remove, 1, contacts[changed[i]].name.c_str(), -1, SQLITE_TRANSIENT);
+        ok = sqlite3_step(remove) == SQLITE_DONE;
+        removed += sqlite3_changes(db);
+        sqlite3_reset(remove);
+    }
+
+    ok = ok && exec(db, "DELETE FROM " + tableName + " WHERE person1 NOT IN (SELECT name FROM main_db.contacts) "
+                        "OR person2 NOT IN (SELECT name FROM main_db.contacts);");
+    if (ok) removed += sqlite3_changes(db);
+
+    int written = 0;
+    for (size_t i = 0; ok && i < pairs.size(); ++i) {
+        const PairScore& p = pairs[i];
+        const std::string& person1 = contacts[p.a].name;
+        const std::string& person2 = contacts[p.b].name;
+        if (person1 == person2) continue;
+
+        std::string label = shared_label(t, p.a, p.b);
+        sqlite3_bind_text(insert, 1, person1.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert, 2, person2.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert, 3, label.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(insert, 4, static_cast<int>(p.overlap));
+        sqlite3_bind_double(insert, 5, p.jaccard);
+        sqlite3_bind_double(insert, 6, p.tfidf);
+        sqlite3_bind_double(insert, 7, p.cosine);
+        ok = sqlite3_step(insert) == SQLITE_DONE;
+        sqlite3_reset(insert);
+        ++written;
+    }
+    if (!ok) std::cerr << "Update of " << table.table << " failed: " << sqlite3_errmsg(db) << std::endl;
+
+    sqlite3_finalize(remove);
+    sqlite3_finalize(insert);
+    ok = ok && exec(db, "COMMIT;");
+    if (!ok) exec(db, "ROLLBACK;");
+    exec(db, "DETACH DATABASE main_db;");
+    sqlite3_close(db);
+
+    if (ok) std::cout << table.table << ": " << removed << " rows removed, " << written << " written" << std::endl;
+    return ok;
+}
+
+
+int main(int argc, char* argv[]) {
+    std::map<std::string, std::string> options = parse_options(argc, argv, 1);
+    OptionReader option(options);
+
+    OverlapOptions overlap;
+    overlap.minOverlap = static_cast<uint32_t>(option.count("min-overlap", overlap.minOverlap));
+    overlap.minJaccard = option.number("min-jaccard", overlap.minJaccard, 0.0, 1.0);
+    overlap.minTfidf = option.number("min-tfidf", overlap.minTfidf, 0.0, 1.0);
+    bool dryRun = options.count("dry-run") > 0;
+
+    bool useLsh = options.count("lsh") > 0;
+    double lshThreshold = option.number("lsh-threshold", 0.5, 0.0, 1.0);
+    int lshHashes = static_cast<int>(option.count("lsh-hashes", 64, 1, 4096));
+    if (!option.ok()) return 1;
+    if (lshThreshold <= 0.0) {
+        std::cerr << "Bad --lsh-threshold value: it must be above 0" << std::endl;
+        return 1;
+    }
+    LshParams lshParams = lsh_params_for(lshThreshold, lshHashes);
+    // LSH only promises pairs near the target, so by default don't keep anything below it
+    if ((useLsh || options.count("match")) && !options.count("min-jaccard")) overlap.minJaccard = lshThreshold;
+
+    bool useEmbed = options.count("embed") > 0;
+    double minCosine = option.number("min-cosine", 0.5, 0.0, 1.0);
+    // the point of embeddings is pairs with no term in common
+    if (useEmbed && !options.count("min-overlap")) overlap.minOverlap = 0;
+    bool useAnn = options.count("ann") > 0;
+    size_t annK = option.count("ann-k", 32, 1);
+    if (!option.ok()) return 1;
+    if (useEmbed && useLsh) {
+        std::cerr << "--embed and --lsh are separate candidate sources, pick one" << std::endl;
+        return 1;
+    }
+
+    if (!options.count("no-dictionary")) {
+        std::string path = options.count("dictionary") ? options["dictionary"] : "synonyms.txt";
+        useDictionary = dictionary.load(path);
+        if (!useDictionary && options.count("dictionary")) {
+            std::cerr << "Could not open " << path << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Field> fields;
+    std::string fieldList = options.count("fields") ? options["fields"] : "skills,interests,career_goals";
+    for (const auto& name : split_values(fieldList)) {
+        int field = -1;
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            if (name == PAIR_TABLES[f].field) field = f;
+        }
+        if (field < 0) {
+            std::cerr << "Unknown field: " << name << std::endl;
+            return 1;
+        }
+        fields.push_back(static_cast<Field>(field));
+    }
+
+    if (options.count("match")) {
+        int contactId = static_cast<int>(option.count("match", 0, 1, INT32_MAX));
+        if (!option.ok()) return 1;
+        json result = json::object();
+        for (Field field : fields) {
+            result[PAIR_TABLES[field].field] = match_contact(contactId, field, overlap);
+        }
+        std::cout << result.dump(2) << std::endl;
+        return 0;
+    }
+
+    if (options.count("nearest")) {
+        int contactId = static_cast<int>(option.count("nearest", 0, 1, INT32_MAX));
+        size_t k = option.count("k", 10, 1);
+        if (!option.ok()) return 1;
+        json result = json::object();
+        for (Field field : fields) {
+            result[PAIR_TABLES[field].field] = nearest_contacts(contactId, field, k);
+        }
+        std::cout << result.dump(2) << std::endl;
+        return 0;
+    }
+
+    if (options.count("index-update")) {
+        std::vector<int> ids = option.ids("index-update");
+        if (!option.ok()) return 1;
+        return update_contact_index(ids) ? 0 : 1;
+    }
+
+    BlockingOptions blocking;
+    if (options.count("candidates")) {
+        if (options.count("min-cosine")) blocking.minCosine = minCosine;
+        blocking.annK = annK;
+        blocking.industryCosine = option.number("industry-cosine", blocking.industryCosine, 0.0, 1.0);
+        blocking.chunkPairs = option.count("chunk-pairs", blocking.chunkPairs, 1);
+        blocking.chunkChars = option.count("chunk-chars", blocking.chunkChars, 1);
+        if (!option.ok()) return 1;
+    }
+
+    std::vector<int> updated = option.ids("update");
+    if (!option.ok()) return 1;
+
+    std::vector<Contact> contacts = load_contacts("my_database.db");
+
+    // stdout is the JSON here, so progress goes to stderr
+    if (options.count("candidates")) {
+        json result = json::object();
+        for (Field field : fields) {
+            result[PAIR_TABLES[field].field] = blocking_candidates(contacts, field, blocking,
+                                                                   load_pair_cache(PAIR_TABLES[field].field));
+        }
+        std::cout << result.dump() << std::endl;
+        return 0;
+    }
+
+    std::cout << "Loaded " << contacts.size() << " contacts." << std::endl;
+
+    if (options.count("update")) {
+        std::set<int> ids(updated.begin(), updated.end());
+
+        std::vector<uint32_t> changed;
+        for (uint32_t c = 0; c < contacts.size(); ++c) {
+            if (ids.count(contacts[c].id)) changed.push_back(c);
+        }
+
+        for (Field field : fields) {
+            TermSets terms = build_term_sets(contacts, field);
+            size_t candidates = 0;
+            std::vector<PairScore> pairs;
+            if (useEmbed) {
+                std::vector<float> embeddings = embed_contacts(contacts, field);
+                pairs = compute_contact_embedding_overlaps(terms, embeddings, changed, overlap, minCosine, candidates);
+            } else {
+                pairs = compute_contact_overlaps(terms, changed, overlap, candidates);
+            }
+            if (!dryRun && !update_pair_table(PAIR_TABLES[field], contacts, terms, changed, pairs)) return 1;
+            std::cout << PAIR_TABLES[field].field << ": " << candidates << " candidate pairs, " << pairs.size() << " kept" << std::endl;
+        }
+
+        std::ifstream existing(CONTACT_INDEX_FILE);
+        if (!dryRun && existing) {
+            existing.close();
+            if (!update_contact_index(std::vector<int>(ids.begin(), ids.end()))) return 1;
+        }
+        return 0;
+    }
+
+    if (options.count("index")) {
+        return build_contact_index(contacts) ? 0 : 1;
+    }
+    if (useEmbed) {
+        const char* kernel;
+        dot_kernel(&kernel);
+        std::cout << "Embedding cosine kernel: " << kernel << std::endl;
+    }
+
+    for (Field field : fields) {
+        const PairTable& table = PAIR_TABLES[field];
+        auto start = std::chrono::steady_clock::now();
+
+        TermSets terms = build_term_sets(contacts, field);
+        size_t candidates = 0;
+        std::vector<PairScore> pairs;
+        std::vector<std::vector<uint32_t>> signatures;
+        std::vector<float> embeddings;
+        if (useEmbed) {
+            embeddings = embed_contacts(contacts, field);
+            pairs = useAnn ? compute_ann_overlaps(terms, embeddings, overlap, minCosine, annK, candidates)
+                           : compute_embedding_overlaps(terms, embeddings, overlap, minCosine, candidates);
+        } else if (useLsh) {
+            pairs = compute_lsh_overlaps(terms, overlap, lshParams, signatures, candidates);
+        } else {
+            pairs = compute_overlaps(terms, overlap, candidates);
+        }
+
+        if (!dryRun && !write_pair_table(table, contacts, terms, pairs)) {
+            std::cerr << "Failed writing " << table.table << std::endl;
+            return 1;
+        }
+        if (!dryRun && useLsh && !store_signatures(table, contacts, signatures, lshParams)) {
+            std::cerr << "Failed storing signatures for " << table.field << std::endl;
+            return 1;
+        }
+        if (!dryRun && useEmbed && !store_embeddings(table, contacts, embeddings)) {
+            std::cerr << "Failed storing embeddings for " << table.field << std::endl;
+            return 1;
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << table.field << ": " << terms.terms.size() << " terms, " << candidates << " candidate pairs, "
+                  << pairs.size() << " kept" << (dryRun ? "" : std::string(" -> ") + table.dbFile)
+                  << " (" << ms << " ms)" << std::endl;
+    }
+
+    return 0;
+}
+
+
+/* to compile use this command
+
+gcc -c sqlite3.c -o sqlite3.o -I.
+g++ shared_text_engine.cpp sqlite3.o -o shared_text_engine -O2 -I. -pthread
+
+*/
@@ -3,5 +3,9 @@ CREATE TABLE IF NOT EXISTS share_goals (
     person1 TEXT,
     person2 TEXT,
     shared_goal TEXT,
+    overlap INTEGER,
+    jaccard REAL,
+    tfidf REAL,
+    cosine REAL,
     UNIQUE(person1, person2)
 );
\ No newline at end of file
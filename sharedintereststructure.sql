@@ -3,5 +3,9 @@ CREATE TABLE IF NOT EXISTS interest_edges (
     person1 TEXT,
     person2 TEXT,
     shared_interests TEXT,
+    overlap INTEGER,
+    jaccard REAL,
+    tfidf REAL,
+    cosine REAL,
     UNIQUE(person1, person2)
 );
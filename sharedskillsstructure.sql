@@ -3,5 +3,9 @@ CREATE TABLE IF NOT EXISTS shared_skills (
     person1 TEXT,
     person2 TEXT,
     shared_skills TEXT,
+    overlap INTEGER,
+    jaccard REAL,
+    tfidf REAL,
+    cosine REAL,
     UNIQUE(person1, person2)
 );
@@ -1,4 +1,6 @@
 import sqlite3
+import subprocess
+import json
 from dataclasses import dataclass
 from itertools import combinations
 import numpy as np
@@ -56,6 +58,72 @@ def load_all_contacts(db_path="my_database.db"):
 
     return [Contact(*row) for row in rows]
 
+def load_candidate_chunks(field):
+    # shared_text_engine drops pairs with no shared term, distant embeddings and no common
+    # industry, answers pairs whose texts were already judged from text_index.db, and batches
+    # the rest into chunks small enough for one request each
+    result = subprocess.run(['./shared_text_engine', '--candidates', f'--fields={field}'],
+                            capture_output=True, text=True)
+    print(result.stderr.strip())
+    if result.returncode != 0:
+        return None
+    report = json.loads(result.stdout)[field]
+    print(f"{field}: {report['candidates']} of {report['total_pairs']} pairs kept "
+          f"({report['prune_ratio']:.1%} pruned), {report['cache_hits']} from cache")
+    return report
+
+
+def cache_results(field, chunk, found, db_path="text_index.db"):
+    # every pair that was asked about is recorded, "" when the model found nothing shared,
+    # keyed by the hash of both texts so it is only asked again once one of them changes
+    if not chunk["keys"]:
+        return
+    labels = {}
+    for p1, p2, label in found:
+        labels[(p1, p2)] = label
+        labels[(p2, p1)] = label
+    rows = [(field, key, labels.get((pair[0], pair[2]), ""))
+            for pair, key in zip(chunk["pairs"], chunk["keys"])]
+
+    conn = sqlite3.connect(db_path)
+    conn.executemany("INSERT OR REPLACE INTO pair_cache (field, pair_hash, label) VALUES (?, ?, ?);", rows)
+    conn.commit()
+    conn.close()
+
+
+def compare_field(contacts, field, attr, ask):
+    report = load_candidate_chunks(field)
+    if report is None:
+        pairs = [[c1.name, getattr(c1, attr), c2.name, getattr(c2, attr)]
+                 for c1, c2 in combinations(contacts, 2) if getattr(c1, attr) and getattr(c2, attr)]
+        report = {"cached_pairs": [], "chunks": [{"pairs": pairs, "keys": []}]}
+
+    insert_batch = [tuple(pair) for pair in report["cached_pairs"]]
+    for chunk in report["chunks"]:
+        result = ask(chunk["pairs"])
+        if result is None:
+            continue  # failed request: nothing to cache, the pairs go out again next run
+        found = []
+        parse_result_lines(result, found)
+        insert_batch.extend(found)
+        cache_results(field, chunk, found)
+    return insert_batch
+
+
+def parse_result_lines(result, insert_batch):
+    if not result:
+        return
+    for line in result.strip().split("\n"):
+        if not line.startswith("[") or not line.endswith("]"):
+            continue
+        try:
+            parts = json.loads(line)
+            if len(parts) == 3 and parts[2].strip().lower() != "none":
+                insert_batch.append((parts[0], parts[1], parts[2]))
+        except Exception as e:
+            print(f"Skipping line due to error: {line} — {e}")
+
+
 def openai_get_interests_in_one_req(comparisons):
     if not comparisons:
         return "array is empty"
@@ -133,27 +201,7 @@ def compare_all_contacts_and_store(contacts, db_path="interests_edges.db"):
         );
     """)
 
-    insert_batch = []
-    combos = []
-
-    for c1, c2 in combinations(contacts, 2):
-        if c1.interests and c2.interests:
-            combos.append([c1.name, c1.interests, c2.name, c2.interests])
-
-    result = openai_get_interests_in_one_req(combos)
-
-    print(result + " = result")
-
-    if result:
-        for line in result.strip().split("\n"):
-            if not line.startswith("[") or not line.endswith("]"):
-                continue
-            try:
-                parts = eval(line)  # safe for trusted input only
-                if len(parts) == 3 and parts[2].strip().lower() != "none":
-                    insert_batch.append((parts[0], parts[1], parts[2]))
-            except Exception as e:
-                print(f"Skipping line due to error: {line} — {e}")
+    insert_batch = compare_field(contacts, "interests", "interests", openai_get_interests_in_one_req)
 
     if insert_batch:
         cur.executemany("""
@@ -220,27 +268,7 @@ def compare_all_goals_and_store(contacts, db_path="goals_edges.db"):
         );
     """)
 
-    insert_batch = []
-    combos = []
-
-    for c1, c2 in combinations(contacts, 2):
-        if c1.career_goals and c2.career_goals:
-            combos.append([c1.name, c1.career_goals, c2.name, c2.career_goals])
-
-    result = openai_get_goals_in_one_req(combos)
-
-    print(result + " = result")
-
-    if result:
-        for line in result.strip().split("\n"):
-            if not line.startswith("[") or not line.endswith("]"):
-                continue
-            try:
-                parts = eval(line)  # safe for trusted input only
-                if len(parts) == 3 and parts[2].strip().lower() != "none":
-                    insert_batch.append((parts[0], parts[1], parts[2]))
-            except Exception as e:
-                print(f"skipping line due to error: {line} — {e}")
+    insert_batch = compare_field(contacts, "career_goals", "career_goals", openai_get_goals_in_one_req)
 
     if insert_batch:
         cur.executemany("""
@@ -376,27 +404,7 @@ def compare_all_skills_and_store(contacts, db_path="skill_edges.db"):
         );
     """)
 
-    insert_batch = []
-    combos = []
-
-    for c1, c2 in combinations(contacts, 2):
-        if c1.skills and c2.skills:
-            combos.append([c1.name, c1.skills, c2.name, c2.skills])
-
-    result = openai_get_goals_in_one_req(combos)
-
-    print(result + " = result")
-
-    if result:
-        for line in result.strip().split("\n"):
-            if not line.startswith("[") or not line.endswith("]"):
-                continue
-            try:
-                parts = eval(line)  # safe for trusted input only
-                if len(parts) == 3 and parts[2].strip().lower() != "none":
-                    insert_batch.append((parts[0], parts[1], parts[2]))
-            except Exception as e:
-                print(f"Skipping line due to error: {line} — {e}")
+    insert_batch = compare_field(contacts, "skills", "skills", openai_get_skills_in_one_req)
 
     if insert_batch:
         cur.executemany("""
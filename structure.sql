@@ -47,3 +47,40 @@ CREATE TABLE IF NOT EXISTS profile (
     talent_rating TEXT,
     FOREIGN KEY(contact_id) REFERENCES contacts(id)
 );
+
+-- Canonical company and school names (see entity_resolution.h)
+CREATE TABLE IF NOT EXISTS organizations (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    kind TEXT NOT NULL,
+    name TEXT NOT NULL
+);
+
+-- Every spelling seen, pointing at its organization
+CREATE TABLE IF NOT EXISTS organization_aliases (
+    kind TEXT NOT NULL,
+    alias TEXT NOT NULL,
+    organization_id INTEGER NOT NULL,
+    PRIMARY KEY (kind, alias),
+    FOREIGN KEY(organization_id) REFERENCES organizations(id)
+);
+
+-- Near misses ("Northwestern" / "Northeastern") kept as their own organization, to confirm by hand
+CREATE TABLE IF NOT EXISTS organization_suggestions (
+    kind TEXT NOT NULL,
+    alias TEXT NOT NULL,
+    organization_id INTEGER NOT NULL,
+    distance INTEGER NOT NULL,
+    PRIMARY KEY (kind, alias),
+    FOREIGN KEY(organization_id) REFERENCES organizations(id)
+);
+
+-- Organizations behind each contact's company and school columns, which keep the raw text
+CREATE TABLE IF NOT EXISTS contact_organizations (
+    contact_id INTEGER NOT NULL,
+    field TEXT NOT NULL,
+    position INTEGER NOT NULL,
+    organization_id INTEGER NOT NULL,
+    PRIMARY KEY (contact_id, field, position),
+    FOREIGN KEY(contact_id) REFERENCES contacts(id),
+    FOREIGN KEY(organization_id) REFERENCES organizations(id)
+);
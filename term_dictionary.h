@@ -0,0 +1,277 @@
+#ifndef TERM_DICTIONARY_H
+#define TERM_DICTIONARY_H
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "pair_map.h"
+#include "text_normalize.h"
+
+// Local stand-in for the "these two mean the same thing" judgement the LLM prompts were making.
+//
+// synonyms.txt holds two kinds of lines (blank lines and # comments are skipped):
+//
+//   canonical: variant, variant, ...     every variant (and the canonical) maps to canonical
+//   child > parent                       anything that maps to child also counts as parent
+//
+// Phrases are casefolded and plural-folded word by word, then compiled into a word-level trie,
+// so canonicalizing a field is one left-to-right scan taking the longest match at each word.
+
+// Light stemming that keeps words readable: plurals and possessives only, e.g.
+// "hobbies" -> "hobby", "classes" -> "class", "skills" -> "skill", "bob's" -> "bob".
+inline std::string fold_word(std::string word) {
+    size_t n = word.size();
+    if (n > 2 && word.compare(n - 2, 2, "'s") == 0) {
+        word.erase(n - 2);
+        n -= 2;
+    }
+    if (n > 4 && word.compare(n - 3, 3, "ies") == 0) {
+        word.replace(n - 3, 3, "y");
+    } else if (n > 4 && (word.compare(n - 4, 4, "sses") == 0 || word.compare(n - 4, 4, "ches") == 0 ||
+                         word.compare(n - 4, 4, "shes") == 0 || word.compare(n - 3, 3, "xes") == 0)) {
+        word.erase(n - 2);
+    } else if (n > 3 && word[n - 1] == 's' && word[n - 2] != 's' && word[n - 2] != 'u' && word[n - 2] != 'i') {
+        word.erase(n - 1);
+    }
+    return word;
+}
+
+
+class TermDictionary {
+public:
+    TermDictionary() { nodes_.push_back(NO_TERM); }
+
+    // False if the file can't be read; the dictionary is still usable and just folds words.
+    bool load(const std::string &path) {
+        std::ifstream file(path);
+        if (!file) return false;
+
+        std::vector<std::pair<std::string, std::string>> parents;
+        std::string line;
+        int lineNumber = 0;
+
+        while (std::getline(file, line)) {
+            ++lineNumber;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            if (normalize_value(line).empty()) continue;
+
+            size_t arrow = line.find('>');
+            size_t colon = line.find(':');
+
+            if (arrow != std::string::npos) {
+                std::string child = key_of(line.substr(0, arrow));
+                std::string parent = key_of(line.substr(arrow + 1));
+                if (child.empty() || parent.empty()) {
+                    std::cerr << path << ":" << lineNumber << ": expected 'child > parent'" << std::endl;
+                    continue;
+                }
+                parents.emplace_back(child, parent);
+            } else if (colon != std::string::npos) {
+                uint32_t canonical = add_term(line.substr(0, colon));
+                if (canonical == NO_TERM) continue;
+                add_phrase(line.substr(0, colon), canonical);
+                for (const auto &variant : split_values(line.substr(colon + 1))) {
+                    add_phrase(variant, canonical);
+                }
+            } else {
+                std::cerr << path << ":" << lineNumber << ": expected 'canonical: variants' or 'child > parent'" << std::endl;
+            }
+        }
+
+        // a hierarchy line may name terms that have no synonym line of their own
+        for (const auto &link : parents) {
+            uint32_t child = term_for_key(link.first);
+            uint32_t parent = term_for_key(link.second);
+            parentOf_[child].push_back(parent);
+        }
+        close_hierarchy();
+        return true;
+    }
+
+    size_t size() const { return terms_.size(); }
+
+    // Canonical form of one comma separated item, or the item as typed (only trimmed) when the
+    // whole item isn't a dictionary phrase. What import stores, so it never stems or lowercases.
+    std::string canonical_item(const std::string &item) const {
+        std::vector<std::string> words = folded_words(item);
+        size_t length = 0;
+        uint32_t term = longest_match(words, 0, length);
+        if (term != NO_TERM && length == words.size()) return terms_.names[term];
+
+        size_t first = item.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) return "";
+        return item.substr(first, item.find_last_not_of(" \t\r\n") - first + 1);
+    }
+
+    // Terms for a comma separated field: each item's canonical form (or its folded text), every
+    // dictionary phrase found inside it, and all of their ancestors.
+    std::vector<std::string> canonicalize_items(const std::string &field) const {
+        std::vector<std::string> out;
+        for (const auto &item : split_values(field)) {
+            std::vector<std::string> words = folded_words(item);
+            if (words.empty()) continue;
+
+            size_t length = 0;
+            uint32_t whole = longest_match(words, 0, length);
+            if (whole != NO_TERM && length == words.size()) {
+                emit(whole, out);
+                continue;
+            }
+
+            out.push_back(join(words, 0, words.size()));
+            scan(words, out, nullptr);
+        }
+        return out;
+    }
+
+    // Terms for free text: dictionary phrases (and ancestors) where they match, the remaining
+    // words folded one by one. Words inside a match are consumed by it.
+    std::vector<std::string> canonicalize_words(const std::string &text) const {
+        std::vector<std::string> out;
+        std::vector<std::string> words;
+        for (auto &word : split_words(text)) words.push_back(fold_word(word));
+        scan(words, out, &out);
+        return out;
+    }
+
+private:
+    static constexpr uint32_t NO_TERM = UINT32_MAX;
+
+    std::vector<std::string> folded_words(const std::string &text) const {
+        std::vector<std::string> words;
+        for (auto &word : split_words(text)) words.push_back(fold_word(word));
+        return words;
+    }
+
+    static std::string join(const std::vector<std::string> &words, size_t begin, size_t end) {
+        std::string out;
+        for (size_t i = begin; i < end; ++i) {
+            if (i > begin) out += ' ';
+            out += words[i];
+        }
+        return out;
+    }
+
+    std::string key_of(const std::string &phrase) const {
+        std::vector<std::string> words = folded_words(phrase);
+        return join(words, 0, words.size());
+    }
+
+    uint32_t add_term(const std::string &name) {
+        std::string display = normalize_value(name);
+        if (display.empty()) return NO_TERM;
+        uint32_t id = terms_.intern(display);
+        if (id == parentOf_.size()) parentOf_.emplace_back();
+        return id;
+    }
+
+    // the term a hierarchy key refers to: whatever the phrase already maps to, else a new term
+    uint32_t term_for_key(const std::string &key) {
+        std::vector<std::string> words;
+        std::string word;
+        for (char c : key + " ") {
+            if (c == ' ') {
+                if (!word.empty()) words.push_back(word);
+                word.clear();
+            } else {
+                word.push_back(c);
+            }
+        }
+        size_t length = 0;
+        uint32_t term = longest_match(words, 0, length);
+        if (term != NO_TERM && length == words.size()) return term;
+
+        term = add_term(key);
+        add_phrase(key, term);
+        return term;
+    }
+
+    void add_phrase(const std::string &phrase, uint32_t term) {
+        uint32_t node = 0;
+        for (const auto &word : folded_words(phrase)) {
+            uint64_t edge = (static_cast<uint64_t>(node) << 32) | words_.intern(word);
+            auto it = edges_.find(edge);
+            if (it == edges_.end()) {
+                uint32_t child = static_cast<uint32_t>(nodes_.size());
+                nodes_.push_back(NO_TERM);
+                it = edges_.emplace(edge, child).first;
+            }
+            node = it->second;
+        }
+        if (node != 0 && nodes_[node] == NO_TERM) nodes_[node] = term;
+    }
+
+    // longest dictionary phrase starting at words[start]; its word count goes to length
+    uint32_t longest_match(const std::vector<std::string> &words, size_t start, size_t &length) const {
+        uint32_t node = 0;
+        uint32_t best = NO_TERM;
+        length = 0;
+
+        for (size_t i = start; i < words.size(); ++i) {
+            auto word = words_.ids.find(words[i]);
+            if (word == words_.ids.end()) break;
+            auto it = edges_.find((static_cast<uint64_t>(node) << 32) | word->second);
+            if (it == edges_.end()) break;
+            node = it->second;
+            if (nodes_[node] != NO_TERM) {
+                best = nodes_[node];
+                length = i - start + 1;
+            }
+        }
+        return best;
+    }
+
+    // one pass over words: matches go to out, unmatched words to leftovers (if given)
+    void scan(const std::vector<std::string> &words, std::vector<std::string> &out,
+              std::vector<std::string> *leftovers) const {
+        for (size_t i = 0; i < words.size();) {
+            size_t length = 0;
+            uint32_t term = longest_match(words, i, length);
+            if (term != NO_TERM) {
+                emit(term, out);
+                i += length;
+            } else {
+                if (leftovers) leftovers->push_back(words[i]);
+                ++i;
+            }
+        }
+    }
+
+    void emit(uint32_t term, std::vector<std::string> &out) const {
+        out.push_back(terms_.names[term]);
+        for (uint32_t ancestor : ancestors_[term]) out.push_back(terms_.names[ancestor]);
+    }
+
+    // flattens parent links so emit() is a plain loop; cycles just stop where they repeat
+    void close_hierarchy() {
+        ancestors_.assign(terms_.size(), {});
+        parentOf_.resize(terms_.size());
+
+        for (uint32_t term = 0; term < terms_.size(); ++term) {
+            std::vector<char> seen(terms_.size(), 0);
+            seen[term] = 1;
+            std::vector<uint32_t> stack(parentOf_[term].begin(), parentOf_[term].end());
+            while (!stack.empty()) {
+                uint32_t parent = stack.back();
+                stack.pop_back();
+                if (seen[parent]) continue;
+                seen[parent] = 1;
+                ancestors_[term].push_back(parent);
+                stack.insert(stack.end(), parentOf_[parent].begin(), parentOf_[parent].end());
+            }
+        }
+    }
+
+    Interner terms_;                                   // canonical display names
+    Interner words_;                                   // folded words seen in any phrase
+    std::vector<uint32_t> nodes_;                      // trie node -> term ending here, or NO_TERM
+    std::unordered_map<uint64_t, uint32_t> edges_;     // (node, word) -> child node
+    std::vector<std::vector<uint32_t>> parentOf_;      // direct parents from "child > parent"
+    std::vector<std::vector<uint32_t>> ancestors_;     // all ancestors, filled by close_hierarchy
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef TEXT_EMBEDDING_H
+#define TEXT_EMBEDDING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "minhash_lsh.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXT_EMBEDDING_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TEXT_EMBEDDING_NEON 1
+#endif
+
+// Deterministic local embeddings for short free text, so "shared goals" can be fuzzy without a
+// remote model. Every term, every pair of neighbouring terms and every character trigram of
+// each word is hashed into one of EMBEDDING_DIM slots with a hash-chosen sign (the hashing trick),
+// then the vector is scaled to unit length. Cosine similarity is then a plain dot product.
+//
+// Trigrams are what make it fuzzy: "programming" and "programmer" share most of theirs, so they
+// land close together even though no whole term matches.
+
+const int EMBEDDING_DIM = 256;
+
+
+inline void add_feature(std::vector<float> &vector, const std::string &feature, float weight) {
+    uint64_t h = mix64(hash_term(feature));
+    vector[h % EMBEDDING_DIM] += (h >> 63) ? -weight : weight;
+}
+
+
+// terms as field_terms() returns them, in text order
+inline std::vector<float> embed_terms(const std::vector<std::string> &terms) {
+    std::vector<float> vector(EMBEDDING_DIM, 0.0f);
+
+    for (size_t i = 0; i < terms.size(); ++i) {
+        add_feature(vector, "t:" + terms[i], 1.0f);
+        if (i + 1 < terms.size()) add_feature(vector, "b:" + terms[i] + " " + terms[i + 1], 0.5f);
+
+        // "^" and "$" mark word edges so prefixes and suffixes get their own trigrams
+        std::string padded = "^" + terms[i] + "$";
+        for (size_t c = 0; c + 3 <= padded.size(); ++c) {
+            if (padded[c + 1] == ' ') continue;
+            add_feature(vector, "c:" + padded.substr(c, 3), 0.25f);
+        }
+    }
+
+    double sum = 0.0;
+    for (float x : vector) sum += static_cast<double>(x) * x;
+    if (sum > 0.0) {
+        float scale = static_cast<float>(1.0 / std::sqrt(sum));
+        for (float &x : vector) x *= scale;
+    }
+    return vector;
+}
+
+
+inline float dot_scalar(const float *a, const float *b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+#ifdef TEXT_EMBEDDING_X86
+__attribute__((target("avx2,fma")))
+inline float dot_avx2(const float *a, const float *b, size_t n) {
+    // two accumulators hide the FMA latency
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+    }
+    __m256 sum = _mm256_add_ps(sum0, sum1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+
+    float total = _mm_cvtss_f32(half);
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+#endif
+
+#ifdef TEXT_EMBEDDING_NEON
+inline float dot_neon(const float *a, const float *b, size_t n) {
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t sum = vaddq_f32(sum0, sum1);
+    float total = vgetq_lane_f32(sum, 0) + vgetq_lane_f32(sum, 1) + vgetq_lane_f32(sum, 2) + vgetq_lane_f32(sum, 3);
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+#endif
+
+
+typedef float (*DotKernel)(const float *, const float *, size_t);
+
+// picked once per process: AVX2 when the CPU has it, NEON on ARM, plain loop otherwise
+inline DotKernel dot_kernel(const char **name = nullptr) {
+    static const char *kernelName = "scalar";
+    static DotKernel kernel = [] {
+#ifdef TEXT_EMBEDDING_X86
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            kernelName = "avx2";
+            return &dot_avx2;
+        }
+#endif
+#ifdef TEXT_EMBEDDING_NEON
+        kernelName = "neon";
+        return &dot_neon;
+#endif
+        return &dot_scalar;
+    }();
+    if (name) *name = kernelName;
+    return kernel;
+}
+
+
+// the k rows of `matrix` (row-major, EMBEDDING_DIM wide) most similar to `query`, best first
+inline std::vector<std::pair<uint32_t, float>> top_k_cosine(const std::vector<float> &matrix, const float *query,
+                                                            size_t k, uint32_t skip = UINT32_MAX) {
+    DotKernel dot = dot_kernel();
+    size_t rows = matrix.size() / EMBEDDING_DIM;
+
+    auto worse = [](const std::pair<uint32_t, float> &x, const std::pair<uint32_t, float> &y) {
+        return x.second > y.second;
+    };
+    // min-heap of the best k so far
+    std::vector<std::pair<uint32_t, float>> best;
+    for (uint32_t r = 0; r < rows; ++r) {
+        if (r == skip) continue;
+        float score = dot(query, matrix.data() + static_cast<size_t>(r) * EMBEDDING_DIM, EMBEDDING_DIM);
+        if (best.size() < k) {
+            best.emplace_back(r, score);
+            std::push_heap(best.begin(), best.end(), worse);
+        } else if (k > 0 && score > best.front().second) {
+            std::pop_heap(best.begin(), best.end(), worse);
+            best.back() = {r, score};
+            std::push_heap(best.begin(), best.end(), worse);
+        }
+    }
+    std::sort_heap(best.begin(), best.end(), worse);
+    return best;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef TEXT_NORMALIZE_H
+#define TEXT_NORMALIZE_H
+
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Trims, lowercases and collapses inner whitespace. This is the grouping key the python
+// group_by_* functions used, so "Google " and "google" land in the same group.
+inline std::string normalize_value(const std::string &value) {
+    std::string out;
+    bool pendingSpace = false;
+
+    for (char c : value) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !out.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            out.push_back(' ');
+            pendingSpace = false;
+        }
+        out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+
+    return out;
+}
+
+
+// Splits a comma separated field into normalized values, dropping empty ones.
+inline std::vector<std::string> split_values(const std::string &field) {
+    std::vector<std::string> values;
+    std::stringstream ss(field);
+    std::string value;
+
+    while (std::getline(ss, value, ',')) {
+        value = normalize_value(value);
+        if (!value.empty()) {
+            values.push_back(value);
+        }
+    }
+
+    return values;
+}
+
+
+// Lowercased alphanumeric runs of free text, e.g. "Get an internship @Google!" -> get, an, internship, google.
+inline std::vector<std::string> split_words(const std::string &text) {
+    std::vector<std::string> words;
+    std::string word;
+
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        // bytes >= 0x80 are kept so UTF-8 letters stay inside their word
+        if (std::isalnum(u) || u >= 0x80) {
+            word.push_back(static_cast<char>(std::tolower(u)));
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) words.push_back(word);
+
+    return words;
+}
+
+#endif
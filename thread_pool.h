@@ -0,0 +1,134 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from one FIFO queue.
+class ThreadPool {
+public:
+    // threads == 0 picks one per core
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto &worker : workers_) worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template <typename Fn>
+    auto submit(Fn fn) -> std::future<decltype(fn())> {
+        using Result = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+        std::future<Result> future = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([task] { (*task)(); });
+        }
+        ready_.notify_one();
+        return future;
+    }
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+};
+
+
+// The process-wide pool, created on first use.
+inline ThreadPool &shared_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+
+// Runs fn(begin, end) over [first, last) split into blocks of at least minBlock items, and
+// returns once every block is done. The calling thread claims blocks too, so this is safe to
+// call from inside a pool task: if every worker is busy the caller just does the work itself.
+template <typename Fn>
+void parallel_for(ThreadPool &pool, size_t first, size_t last, Fn fn, size_t minBlock = 1024) {
+    if (last <= first) return;
+
+    size_t count = last - first;
+    size_t blockSize = std::max(minBlock, (count + pool.size() * 4 - 1) / (pool.size() * 4));
+    size_t blocks = (count + blockSize - 1) / blockSize;
+
+    if (blocks == 1) {
+        fn(first, last);
+        return;
+    }
+
+    // shared so helpers that only get scheduled after we return still see valid state
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+
+    auto claim = [state, first, last, blockSize, blocks, fn]() {
+        for (;;) {
+            size_t block = state->next.fetch_add(1);
+            if (block >= blocks) return;
+
+            size_t begin = first + block * blockSize;
+            fn(begin, std::min(last, begin + blockSize));
+
+            if (state->done.fetch_add(1) + 1 == blocks) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min<size_t>(pool.size(), blocks - 1);
+    for (size_t i = 0; i < helpers; ++i) pool.submit(claim);
+
+    claim();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == blocks; });
+}
+
+#endif